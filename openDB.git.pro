@@ -8,38 +8,63 @@ DEPENDPATH += . src
 INCLUDEPATH += . src
 
 # Input
-HEADERS += src/column.hpp \
+HEADERS += src/arena.hpp \
+           src/buffer_pool.hpp \
+           src/cell.hpp \
+           src/column.hpp \
+           src/column_storage.hpp \
            src/common.hpp \
            src/connection.hpp \
            src/database.hpp \
            src/dbms.hpp \
+           src/dictionary.hpp \
            src/exception.hpp \
            src/file_storage.hpp \
+           src/hybrid_storage.hpp \
            src/insert_table.hpp \
+           src/io_ring.hpp \
            src/login_dialog.hpp \
            src/memory_storage.hpp \
+           src/mmap_storage.hpp \
+           src/page_storage.hpp \
            src/queryAttribute.hpp \
            src/record.hpp \
+           src/record_cache.hpp \
            src/schema.hpp \
            src/sqlType.hpp \
            src/storage.hpp \
            src/table.hpp \
+           src/thread_pool.hpp \
+           src/trash.hpp \
            src/update_table.hpp \
            src/view.hpp
 SOURCES += unitTest.cpp \
+           src/arena.cpp \
+           src/buffer_pool.cpp \
+           src/cell.cpp \
            src/column.cpp \
+           src/column_storage.cpp \
            src/common.cpp \
            src/connection.cpp \
            src/database.cpp \
            src/dbms.cpp \
+           src/dictionary.cpp \
            src/file_storage.cpp \
+           src/hybrid_storage.cpp \
            src/insert_table.cpp \
+           src/io_ring.cpp \
            src/login_dialog.cpp \
            src/memory_storage.cpp \
+           src/mmap_storage.cpp \
+           src/page_storage.cpp \
            src/queryAttribute.cpp \
            src/record.cpp \
+           src/record_cache.cpp \
            src/schema.cpp \
            src/sqlType.cpp \
+           src/storage.cpp \
            src/table.cpp \
+           src/thread_pool.cpp \
+           src/trash.cpp \
            src/update_table.cpp \
            src/view.cpp
@@ -0,0 +1,77 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "arena.hpp"
+using namespace openDB;
+
+arena::~arena () throw () {
+	for (std::vector<char*>::const_iterator it = __chunks.begin(); it != __chunks.end(); it++)
+		::operator delete(*it);
+}
+
+void* arena::allocate (std::size_t bytes, std::size_t alignment) {
+	if (bytes > large_size) {
+		__large++;
+		return ::operator new(bytes);
+	}
+	char* pointer = align(__next, alignment);
+	if (!__next || pointer + bytes > __end) {
+		__chunks.push_back(static_cast<char*>(::operator new(__chunk_size)));
+		__end = __chunks.back() + __chunk_size;
+		pointer = align(__chunks.back(), alignment);
+	}
+	__next = pointer + bytes;
+	__used += bytes;
+	__allocations++;
+	return pointer;
+}
+
+void arena::deallocate (void* pointer, std::size_t bytes) throw () {
+	if (bytes > large_size) {
+		__large--;
+		::operator delete(pointer);
+		return;
+	}
+	// l'ultima area assegnata può essere restituita al blocco corrente
+	if (static_cast<char*>(pointer) + bytes == __next) {
+		__next = static_cast<char*>(pointer);
+		__used -= bytes;
+	}
+	else
+		__released += bytes;
+}
+
+void arena::clear () throw () {
+	if (__chunks.empty())
+		return;
+	for (std::vector<char*>::const_iterator it = __chunks.begin() + 1; it != __chunks.end(); it++)
+		::operator delete(*it);
+	__chunks.resize(1);
+	__next = __chunks.front();
+	__end = __next + __chunk_size;
+	__used = __released = 0;
+	__allocations = 0;
+}
+
+arena::statistics arena::stats () const throw () {
+	statistics result;
+	result.chunks = __chunks.size();
+	result.reserved = __chunks.size() * __chunk_size;
+	result.used = __used;
+	result.released = __released;
+	result.allocations = __allocations;
+	result.large = __large;
+	return result;
+}
+
+char* arena::align (char* pointer, std::size_t alignment) throw () {
+	return reinterpret_cast<char*>((reinterpret_cast<std::size_t>(pointer) + alignment - 1) & ~(alignment - 1));
+}
@@ -0,0 +1,120 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OPENDB_ARENA_HEADER__
+#define __OPENDB_ARENA_HEADER__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+namespace openDB {
+/* La classe arena implementa un allocatore monotono: la memoria viene assegnata in sequenza da blocchi (chunk) di grandi dimensioni, per cui ogni allocazione
+ * si riduce all'avanzamento di un puntatore, mentre le deallocazioni non restituiscono la memoria, che viene liberata tutta insieme dalla funzione clear o dal
+ * distruttore. È indicata per oggetti che vengono creati in gran numero e distrutti tutti insieme, come le tuple di una tabella (vedi memory_storage.hpp).
+ * Le richieste più grandi di large_size byte non vengono servite dai blocchi, ma allocate e deallocate singolarmente, in modo da non sprecare memoria per
+ * oggetti, come la tabella dei bucket di un std::unordered_map, che vengono riallocati quando crescono.
+ */
+class arena {
+public:
+		/* La struttura statistics raccoglie i contatori relativi all'utilizzo dell'arena:
+		 * 	- chunks: numero di blocchi attualmente allocati;
+		 * 	- reserved: byte complessivamente allocati per i blocchi;
+		 * 	- used: byte assegnati dai blocchi dall'ultima chiamata a clear, compresi quelli già deallocati;
+		 * 	- released: byte deallocati dall'ultima chiamata a clear, che non potranno essere riutilizzati prima della successiva;
+		 * 	- allocations: numero di allocazioni servite dai blocchi dall'ultima chiamata a clear;
+		 * 	- large: numero di allocazioni di grandi dimensioni attualmente in uso.
+		 */
+		struct statistics {
+				std::size_t		chunks;
+				std::size_t		reserved;
+				std::size_t		used;
+				std::size_t		released;
+				unsigned long	allocations;
+				unsigned long	large;
+				statistics() : chunks(0), reserved(0), used(0), released(0), allocations(0), large(0) {}
+		};
+
+		explicit arena (std::size_t chunk_size = default_chunk_size) throw () : __chunk_size(chunk_size < 2 * large_size ? 2 * large_size : chunk_size), __next(0), __end(0), __used(0), __released(0), __allocations(0), __large(0) {}
+		~arena () throw ();
+
+		/* La funzione allocate restituisce l'indirizzo di un'area di bytes byte allineata ad alignment, che deve essere una potenza di due. La funzione
+		 * deallocate rilascia un'area restituita da allocate, con la stessa dimensione.
+		 */
+		void* allocate (std::size_t bytes, std::size_t alignment);
+		void deallocate (void* pointer, std::size_t bytes) throw ();
+
+		/* La funzione clear libera tutta la memoria assegnata dai blocchi, mantenendo soltanto il primo blocco per le allocazioni successive. Tutti gli oggetti
+		 * allocati nell'arena devono essere già stati distrutti.
+		 */
+		void clear () throw ();
+
+		statistics stats () const throw ();
+
+		static const std::size_t default_chunk_size = 1048576;		/*	1 MiB	*/
+		static const std::size_t large_size = 65536;
+
+private:
+		arena (const arena&);
+		arena& operator= (const arena&);
+		static char* align (char* pointer, std::size_t alignment) throw ();
+
+		std::size_t			__chunk_size;
+		std::vector<char*>	__chunks;
+		char*				__next;			/*	primo byte libero del blocco corrente	*/
+		char*				__end;			/*	fine del blocco corrente	*/
+		std::size_t			__used;
+		std::size_t			__released;
+		unsigned long		__allocations;
+		unsigned long		__large;
+};
+
+/* arena_allocator è un allocatore, nel senso della libreria standard, che assegna la memoria da un oggetto arena, in modo che i contenitori possano
+ * allocare i propri elementi nell'arena. Un arena_allocator costruito senza arena alloca la memoria con operator new, come std::allocator.
+ * La copia di un contenitore non utilizza l'arena dell'originale, per cui può sopravvivere ad essa; lo spostamento e lo scambio, invece, trasferiscono
+ * anche l'allocatore.
+ */
+template <typename T> class arena_allocator {
+public:
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+		typedef std::false_type propagate_on_container_copy_assignment;
+		template <typename U> struct rebind {
+				typedef arena_allocator<U> other;
+		};
+
+		arena_allocator (arena* _arena = 0) throw () : __arena(_arena) {}
+		template <typename U> arena_allocator (const arena_allocator<U>& allocator) throw () : __arena(allocator.get_arena()) {}
+
+		T* allocate (std::size_t n)
+				{return static_cast<T*>(__arena ? __arena->allocate(n * sizeof(T), alignof(T)) : ::operator new(n * sizeof(T)));}
+		void deallocate (T* pointer, std::size_t n) throw ()
+				{if (__arena) __arena->deallocate(pointer, n * sizeof(T)); else ::operator delete(pointer);}
+
+		arena_allocator select_on_container_copy_construction () const throw ()
+				{return arena_allocator();}
+
+		arena* get_arena () const throw ()
+				{return __arena;}
+
+private:
+		arena*	__arena;
+};
+
+template <typename T, typename U> bool operator== (const arena_allocator<T>& a, const arena_allocator<U>& b) throw ()
+		{return a.get_arena() == b.get_arena();}
+template <typename T, typename U> bool operator!= (const arena_allocator<T>& a, const arena_allocator<U>& b) throw ()
+		{return a.get_arena() != b.get_arena();}
+}; /*	end of openDB namespace	*/
+#endif
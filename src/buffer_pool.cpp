@@ -0,0 +1,175 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "buffer_pool.hpp"
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+using namespace openDB;
+
+static bool positional_read (int fd, char* buffer, std::size_t count, off_t offset) {
+	while (count > 0) {
+		ssize_t done = pread(fd, buffer, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		buffer += done;
+		offset += done;
+		count -= done;
+	}
+	return true;
+}
+
+static bool positional_write (int fd, const char* buffer, std::size_t count, off_t offset) {
+	while (count > 0) {
+		ssize_t done = pwrite(fd, buffer, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		buffer += done;
+		offset += done;
+		count -= done;
+	}
+	return true;
+}
+
+buffer_pool::buffer_pool (int fd, std::size_t pageSize, std::size_t budget) throw () : __fd(fd), __pageSize(pageSize), __budget(budget), __resident(0), __hand(0),
+	__hits(0), __misses(0), __evictions(0), __writes(0) {}
+
+buffer_pool::~buffer_pool() {
+	discard();
+}
+
+char* buffer_pool::get (unsigned long page, unsigned span, bool fresh) throw (storage_exception&) {
+	std::unordered_map<unsigned long, frame>::iterator it = __frames.find(page);
+	if (it != __frames.end() && it->second.span == span) {
+		__hits++;
+		it->second.referenced = true;
+		if (fresh) {
+			std::memset(it->second.data, 0, span * __pageSize);
+			it->second.dirty = true;
+		}
+		return it->second.data;
+	}
+	if (it != __frames.end())		//il blocco è stato riorganizzato con un numero diverso di pagine
+		free(release(page));
+	__misses++;
+	std::size_t byte = span * __pageSize;
+	void* data = evict(byte, span);
+	if (!data && posix_memalign(&data, alignment, byte) != 0)
+		throw io_error("I/O error: can not allocate " + std::to_string(byte) + " bytes for the buffer pool!");
+	if (fresh)
+		std::memset(data, 0, byte);
+	else
+		if (!positional_read(__fd, static_cast<char*>(data), byte, (off_t) (page * __pageSize))) {
+			free(data);
+			throw io_error("I/O error: page " + std::to_string(page) + " can not be read!");
+		}
+	frame _frame;
+	_frame.data = static_cast<char*>(data);
+	_frame.span = span;
+	_frame.dirty = fresh;
+	_frame.referenced = true;
+	_frame.position = __clock.size();
+	__frames.insert(std::pair<unsigned long, frame>(page, _frame));
+	__clock.push_back(page);
+	__resident += byte;
+	return _frame.data;
+}
+
+void buffer_pool::dirty (unsigned long page) throw () {
+	std::unordered_map<unsigned long, frame>::iterator it = __frames.find(page);
+	if (it != __frames.end())
+		it->second.dirty = true;
+}
+
+void buffer_pool::flush () throw (storage_exception&) {
+	std::vector<unsigned long> pages;
+	for (std::unordered_map<unsigned long, frame>::const_iterator it = __frames.begin(); it != __frames.end(); it++)
+		if (it->second.dirty)
+			pages.push_back(it->first);
+	std::sort(pages.begin(), pages.end());
+	for (std::vector<unsigned long>::const_iterator it = pages.begin(); it != pages.end(); it++)
+		writeback(*it, __frames.find(*it)->second);
+}
+
+void buffer_pool::drop (unsigned long page) throw () {
+	if (__frames.find(page) != __frames.end())
+		free(release(page));
+}
+
+void buffer_pool::discard () throw () {
+	for (std::unordered_map<unsigned long, frame>::iterator it = __frames.begin(); it != __frames.end(); it++)
+		free(it->second.data);
+	__frames.clear();
+	__clock.clear();
+	__hand = 0;
+	__resident = 0;
+}
+
+buffer_pool::statistics buffer_pool::stats () const throw () {
+	statistics _stats;
+	_stats.hits = __hits;
+	_stats.misses = __misses;
+	_stats.evictions = __evictions;
+	_stats.writes = __writes;
+	_stats.resident = __resident;
+	return _stats;
+}
+
+char* buffer_pool::evict (std::size_t byte, unsigned span) throw (storage_exception&) {
+	char* reusable = 0;
+	while (!__clock.empty() && __resident + byte > __budget) {
+		if (__hand >= __clock.size())
+			__hand = 0;
+		unsigned long page = __clock[__hand];
+		frame& _frame = __frames.find(page)->second;
+		if (_frame.referenced) {		//seconda possibilità: il blocco verrà rimosso al prossimo passaggio della lancetta, se non viene usato prima
+			_frame.referenced = false;
+			__hand++;
+			continue;
+		}
+		if (_frame.dirty)
+			writeback(page, _frame);
+		bool same = (_frame.span == span && !reusable);
+		char* data = release(page);
+		if (same)
+			reusable = data;
+		else
+			free(data);
+		__evictions++;
+	}
+	return reusable;
+}
+
+void buffer_pool::writeback (unsigned long page, frame& _frame) throw (storage_exception&) {
+	if (!positional_write(__fd, _frame.data, _frame.span * __pageSize, (off_t) (page * __pageSize)))
+		throw io_error("I/O error: page " + std::to_string(page) + " can not be written!");
+	_frame.dirty = false;
+	__writes++;
+}
+
+char* buffer_pool::release (unsigned long page) throw () {
+	std::unordered_map<unsigned long, frame>::iterator it = __frames.find(page);
+	__resident -= it->second.span * __pageSize;
+	char* data = it->second.data;
+	std::size_t position = it->second.position;
+	__frames.erase(it);
+	__clock[position] = __clock.back();
+	__clock.pop_back();
+	if (position < __clock.size())
+		__frames.find(__clock[position])->second.position = position;
+	return data;
+}
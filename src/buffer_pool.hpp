@@ -0,0 +1,125 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_BUFFER_POOL_HEADER__
+#define __OPENDB_BUFFER_POOL_HEADER__
+
+#include "exception.hpp"
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace openDB {
+/* La classe buffer_pool mantiene in memoria una parte delle pagine di un file (vedi page_storage.hpp), entro un limite massimo di memoria occupata.
+ * Una pagina è un blocco di page_size byte che inizia ad un offset multiplo di page_size; più pagine consecutive possono essere gestite come un unico blocco
+ * (span), ad esempio per contenere un record più grande di una pagina. Ogni blocco è identificato dal numero della sua prima pagina.
+ * I blocchi vengono letti dal file la prima volta che vengono richiesti e restano in memoria finchè lo spazio non serve ad altri blocchi: in tal caso viene
+ * scelto il blocco da rimuovere con l'algoritmo clock (second chance), che approssima la politica LRU senza dover riordinare i blocchi ad ogni accesso. I
+ * blocchi modificati vengono scritti sul file solo quando vengono rimossi dalla memoria o alla chiamata di flush.
+ * La memoria dei blocchi è allineata ad alignment byte e page_size deve esserne un multiplo, per cui tutte le letture e le scritture sono allineate.
+ * Un oggetto buffer_pool non può essere usato contemporaneamente da più thread.
+ */
+class buffer_pool {
+public:
+		/* La struttura statistics raccoglie i contatori relativi all'utilizzo della memoria:
+		 * 	- hits: numero di richieste soddisfatte da un blocco già in memoria;
+		 * 	- misses: numero di richieste che hanno richiesto di leggere o creare un blocco;
+		 * 	- evictions: numero di blocchi rimossi dalla memoria per fare spazio ad altri;
+		 * 	- writes: numero di blocchi scritti sul file;
+		 * 	- resident: numero di byte attualmente occupati dai blocchi in memoria.
+		 */
+		struct statistics {
+				unsigned long	hits;
+				unsigned long	misses;
+				unsigned long	evictions;
+				unsigned long	writes;
+				std::size_t		resident;
+				statistics() : hits(0), misses(0), evictions(0), writes(0), resident(0) {}
+		};
+
+		/* Il costruttore crea un buffer vuoto per il file fd, già aperto in lettura e scrittura, con pagine di pageSize byte e una occupazione massima di
+		 * budget byte. Il buffer può superare il limite solo se un singolo blocco è più grande di budget. Il distruttore libera la memoria senza scrivere i
+		 * blocchi modificati: è compito del proprietario chiamare flush.
+		 */
+		buffer_pool (int fd, std::size_t pageSize, std::size_t budget) throw ();
+		~buffer_pool();
+
+		buffer_pool(const buffer_pool&) = delete;
+		buffer_pool& operator= (const buffer_pool&) = delete;
+
+		/* La funzione get restituisce l'indirizzo in memoria del blocco di span pagine che inizia con la pagina page, leggendolo dal file se necessario. Se fresh
+		 * è true il blocco non viene letto, ma inizializzato con zeri e marcato come modificato: va usato per i blocchi che non sono mai stati scritti.
+		 * L'indirizzo resta valido fino alla successiva chiamata di get, drop o discard.
+		 * Viene generata una eccezione di tipo io_error se non è possibile leggere il blocco o scrivere il blocco rimosso per fargli spazio.
+		 */
+		char* get (unsigned long page, unsigned span, bool fresh = false) throw (storage_exception&);
+
+		/* La funzione dirty marca come modificato il blocco che inizia con la pagina page, che deve essere in memoria.
+		 */
+		void dirty (unsigned long page) throw ();
+
+		/* La funzione flush scrive sul file tutti i blocchi modificati, in ordine di offset. I blocchi restano in memoria. Viene generata una eccezione di tipo
+		 * io_error se una scrittura non va a buon fine.
+		 */
+		void flush () throw (storage_exception&);
+
+		/* La funzione drop rimuove dalla memoria il blocco che inizia con la pagina page senza scriverlo. La funzione discard rimuove tutti i blocchi.
+		 */
+		void drop (unsigned long page) throw ();
+		void discard () throw ();
+
+		/* La funzione budget modifica l'occupazione massima di memoria; i blocchi in eccesso vengono rimossi alla successiva chiamata di get.
+		 */
+		void budget (std::size_t _budget) throw ()
+			{__budget = _budget;}
+		std::size_t budget () const throw ()
+			{return __budget;}
+
+		std::size_t page_size () const throw ()
+			{return __pageSize;}
+
+		statistics stats () const throw ();
+
+		static const std::size_t alignment = 4096;
+
+private:
+		struct frame {
+				char*		data;
+				unsigned	span;
+				bool		dirty;
+				bool		referenced;
+				std::size_t	position;		/*	posizione del blocco in __clock	*/
+		};
+
+		int												__fd;
+		std::size_t										__pageSize;
+		std::size_t										__budget;
+		std::size_t										__resident;		/*	byte occupati dai blocchi in memoria	*/
+		std::unordered_map<unsigned long, frame>		__frames;
+		std::vector<unsigned long>						__clock;		/*	pagine dei blocchi in memoria, percorse circolarmente dalla lancetta __hand	*/
+		std::size_t										__hand;
+		unsigned long									__hits;
+		unsigned long									__misses;
+		unsigned long									__evictions;
+		unsigned long									__writes;
+
+		/* La funzione evict rimuove blocchi dalla memoria finchè non ci sono almeno byte byte disponibili, scrivendo quelli modificati. Se uno dei blocchi rimossi
+		 * è composto da span pagine, la sua memoria non viene liberata ma restituita, in modo che possa essere riutilizzata per il nuovo blocco; altrimenti
+		 * restituisce 0. La funzione writeback scrive un blocco sul file. La funzione release rimuove un blocco e ne restituisce la memoria, che deve essere
+		 * liberata dal chiamante.
+		 */
+		char* evict (std::size_t byte, unsigned span) throw (storage_exception&);
+		void writeback (unsigned long page, frame& _frame) throw (storage_exception&);
+		char* release (unsigned long page) throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
@@ -0,0 +1,577 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "cell.hpp"
+#include "arena.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <iterator>
+#include <limits>
+using namespace openDB;
+
+cell::cell (const cell& _cell) throw () : __tag(local_text) {
+	*this = _cell;
+}
+
+cell::cell (cell&& _cell) throw () : __tag(_cell.__tag) {
+	std::memcpy(__bytes, _cell.__bytes, local_size);
+	_cell.__tag = local_text;
+}
+
+cell& cell::operator= (const cell& _cell) throw () {
+	if (this == &_cell)
+		return *this;
+	if (_cell.external())
+		assign_text(_cell.data(), _cell.length());
+	else {
+		release();
+		std::memcpy(__bytes, _cell.__bytes, local_size);
+		__tag = _cell.__tag;
+	}
+	return *this;
+}
+
+cell& cell::operator= (cell&& _cell) throw () {
+	if (this == &_cell)
+		return *this;
+	release();
+	std::memcpy(__bytes, _cell.__bytes, local_size);
+	__tag = _cell.__tag;
+	_cell.__tag = local_text;
+	return *this;
+}
+
+void cell::release () throw () {
+	if (kind() == heap_text)
+		delete[] get<char*>(0);
+	__tag = local_text;
+}
+
+void cell::assign_text (const char* value, std::size_t size, arena* _arena) throw () {
+	release();
+	if (size <= local_size) {
+		std::memcpy(__bytes, value, size);
+		__tag = (unsigned char) (local_text | (size << 4));
+	}
+	else {
+		char* block = (_arena ? static_cast<char*>(_arena->allocate(size, 1)) : new char[size]);
+		std::memcpy(block, value, size);
+		set<char*>(0, block);
+		set<std::uint32_t>(extra, (std::uint32_t) size);
+		__tag = (_arena ? shared_text : heap_text);
+	}
+}
+
+void cell::assign (const std::string& value, enum sqlType::native_type type, arena* _arena) throw () {
+	if (type == sqlType::as_text || !encode(value, type))
+		assign_text(value.data(), value.size(), _arena);
+}
+
+void cell::share (const std::string& value) throw () {
+	if (value.size() <= local_size)
+		assign_text(value.data(), value.size());
+	else {
+		release();
+		set<const char*>(0, value.data());
+		set<std::uint32_t>(extra, (std::uint32_t) value.size());
+		__tag = shared_text;
+	}
+}
+
+void cell::alias (const cell& _cell) throw () {
+	if (this == &_cell)
+		return;
+	release();
+	std::memcpy(__bytes, _cell.__bytes, local_size);
+	__tag = (_cell.external() ? (unsigned char) shared_text : _cell.__tag);
+}
+
+std::string cell::text () const throw () {
+	if (!native())
+		return std::string(data(), length());
+	char buffer[64];
+	return std::string(buffer, format(buffer));
+}
+
+void cell::append (std::string& value) const throw () {
+	if (!native())
+		value.append(data(), length());
+	else {
+		char buffer[64];
+		value.append(buffer, format(buffer));
+	}
+}
+
+void cell::view (field& _field) const throw () {
+	if (!native()) {
+		_field.__data = data();
+		_field.__size = length();
+	}
+	else {
+		_field.__data = _field.__buffer;
+		_field.__size = format(_field.__buffer);
+	}
+}
+
+static bool number (const char* buffer, std::size_t size, unsigned& value) {
+	value = 0;
+	for (std::size_t i = 0; i < size; i++) {
+		if (buffer[i] < '0' || buffer[i] > '9')
+			return false;
+		value = value * 10 + (buffer[i] - '0');
+	}
+	return size > 0;
+}
+
+/* La funzione digits legge, a partire da buffer, una sequenza di cifre decimali senza zeri iniziali superflui, accumulandola in value; restituisce il numero
+ * di cifre lette, o 0 se la sequenza non è in forma canonica o supera le 19 cifre.
+ */
+static unsigned digits (const char*& buffer, const char* end, unsigned long long& value) {
+	const char* begin = buffer;
+	value = 0;
+	for (; buffer != end && *buffer >= '0' && *buffer <= '9'; buffer++) {
+		if (buffer - begin == 19)
+			return 0;
+		value = value * 10 + (*buffer - '0');
+	}
+	if (buffer == begin || (*begin == '0' && buffer - begin > 1))
+		return 0;
+	return buffer - begin;
+}
+
+static unsigned significant_digits (const char* buffer, const char* end) {
+	unsigned count = 0;
+	bool leading = true;
+	for (; buffer != end && *buffer != 'e' && *buffer != 'E'; buffer++)
+		if ((*buffer >= '1' && *buffer <= '9') || (*buffer == '0' && !leading)) {
+			leading = false;
+			count++;
+		}
+	return (count > 0 ? count : 1);
+}
+
+/* La funzione encode converte value nella rappresentazione nativa type, solo se la conversione inversa restituisce esattamente value (vedi format): gli interi,
+ * ad esempio, non devono avere zeri iniziali né il segno '+'. Restituisce false, lasciando la cella invariata, in caso contrario.
+ * I numeri in virgola mobile scritti senza esponente vengono memorizzati come decimali scalati, che rappresentano esattamente la stringa senza richiederne la
+ * conversione, molto più lenta, da e verso double.
+ */
+bool cell::encode (const std::string& value, enum sqlType::native_type type) throw () {
+	const char* begin = value.c_str();
+	const char* end = begin + value.size();
+	if (value.empty() || value.size() > 32)
+		return false;
+	switch (type) {
+		case sqlType::as_integer :
+		case sqlType::as_decimal : {
+			bool negative = (*begin == '-');
+			const char* it = begin + (negative ? 1 : 0);
+			unsigned long long integral, fraction = 0;
+			unsigned count = digits(it, end, integral), scale = 0;
+			if (count == 0)
+				return false;
+			if (type == sqlType::as_decimal && it != end && *it == '.') {
+				const char* point = ++it;
+				for (; it != end && *it >= '0' && *it <= '9'; it++)
+					fraction = fraction * 10 + (*it - '0');
+				scale = it - point;
+				if (scale == 0)
+					return false;
+			}
+			if (it != end || count + scale > 18 + (type == sqlType::as_integer ? 1 : 0))
+				return false;
+			unsigned long long magnitude = integral;
+			for (unsigned i = 0; i < scale; i++)
+				magnitude *= 10;
+			magnitude += fraction;
+			if (magnitude > (unsigned long long) std::numeric_limits<long long>::max() + (negative ? 1 : 0) || (negative && magnitude == 0))
+				return false;
+			release();
+			set<long long>(0, (negative ? (long long) (0 - magnitude) : (long long) magnitude));
+			if (type == sqlType::as_decimal) {
+				__bytes[extra] = (char) scale;
+				__tag = decimal;
+			}
+			else
+				__tag = integer;
+			return true;
+		}
+		case sqlType::as_float :
+		case sqlType::as_double : {
+			if (encode(value, sqlType::as_decimal))
+				return true;
+			unsigned precision = significant_digits(begin, end);
+			char* stop = 0;
+			double _double = (type == sqlType::as_float ? std::strtof(begin, &stop) : std::strtod(begin, &stop));
+			if (stop != end || precision > (type == sqlType::as_float ? 9u : 17u))
+				return false;
+			char buffer[64];
+			if (std::sprintf(buffer, "%.*g", (int) precision, _double) != (int) value.size() || std::memcmp(buffer, begin, value.size()) != 0)
+				return false;
+			release();
+			if (type == sqlType::as_float) {
+				set<float>(0, (float) _double);
+				__tag = float32;
+			}
+			else {
+				set<double>(0, _double);
+				__tag = float64;
+			}
+			__bytes[extra] = (char) precision;
+			return true;
+		}
+		case sqlType::as_date : {
+			unsigned day, month, year;
+			enum representation form;
+			if (value.size() == 10 && value[4] == '-' && value[7] == '-' && number(begin, 4, year) && number(begin + 5, 2, month) && number(begin + 8, 2, day))
+				form = date_iso;
+			else if (value.size() >= 7 && value.size() <= 11 && value[2] == '/' && value[5] == '/' && value[6] != '0' && number(begin, 2, day) && number(begin + 3, 2, month) && number(begin + 6, value.size() - 6, year))
+				form = date_dmy;
+			else
+				return false;
+			if (day > 31 || month > 15)
+				return false;
+			release();
+			set<std::uint32_t>(0, year * 512 + month * 32 + day);
+			__tag = form;
+			return true;
+		}
+		case sqlType::as_time : {
+			unsigned hour, minute, second;
+			if (value.size() != 8 || value[2] != ':' || value[5] != ':' || !number(begin, 2, hour) || !number(begin + 3, 2, minute) || !number(begin + 6, 2, second) || minute > 59 || second > 59)
+				return false;
+			release();
+			set<std::uint32_t>(0, hour * 3600 + minute * 60 + second);
+			__tag = time;
+			return true;
+		}
+		case sqlType::as_boolean : {
+			unsigned char index = 0;
+			for (std::list<std::string>::const_iterator it = sqlType::boolean::true_value.begin(); it != sqlType::boolean::true_value.end(); it++, index++)
+				if (value == *it) {
+					release();
+					__bytes[0] = (char) index;
+					__tag = boolean;
+					return true;
+				}
+			for (std::list<std::string>::const_iterator it = sqlType::boolean::false_value.begin(); it != sqlType::boolean::false_value.end(); it++, index++)
+				if (value == *it) {
+					release();
+					__bytes[0] = (char) index;
+					__tag = boolean;
+					return true;
+				}
+			return false;
+		}
+		default :
+			return false;
+	}
+}
+
+/* Le funzioni seguenti scrivono in buffer le cifre decimali di value, con almeno width cifre, e restituiscono il numero di byte scritti. */
+static std::size_t put_digits (char* buffer, unsigned long long value, std::size_t width = 1) {
+	char digits[24];
+	std::size_t count = 0;
+	do {
+		digits[count++] = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	for (; count < width; )
+		digits[count++] = '0';
+	for (std::size_t i = 0; i < count; i++)
+		buffer[i] = digits[count - 1 - i];
+	return count;
+}
+
+/* La funzione format scrive in buffer, che deve contenere almeno 64 byte, la stringa corrispondente al valore nativo e ne restituisce la lunghezza.
+ */
+std::size_t cell::format (char* buffer) const throw () {
+	std::size_t size = 0;
+	switch (kind()) {
+		case integer :
+		case decimal : {
+			long long value = get<long long>(0);
+			std::size_t scale = (kind() == decimal ? (unsigned char) __bytes[extra] : 0);
+			unsigned long long magnitude = (value < 0 ? 0 - (unsigned long long) value : (unsigned long long) value);
+			if (value < 0)
+				buffer[size++] = '-';
+			char digits[24];
+			std::size_t count = put_digits(digits, magnitude, scale + 1);
+			std::memcpy(buffer + size, digits, count - scale);
+			size += count - scale;
+			if (scale > 0) {
+				buffer[size++] = '.';
+				std::memcpy(buffer + size, digits + count - scale, scale);
+				size += scale;
+			}
+			break;
+		}
+		case float32 :
+			size = std::sprintf(buffer, "%.*g", (int) __bytes[extra], (double) get<float>(0));
+			break;
+		case float64 :
+			size = std::sprintf(buffer, "%.*g", (int) __bytes[extra], get<double>(0));
+			break;
+		case date_dmy : {
+			std::uint32_t packed = get<std::uint32_t>(0);
+			size += put_digits(buffer + size, packed % 32, 2);
+			buffer[size++] = '/';
+			size += put_digits(buffer + size, (packed / 32) % 16, 2);
+			buffer[size++] = '/';
+			size += put_digits(buffer + size, packed / 512);
+			break;
+		}
+		case date_iso : {
+			std::uint32_t packed = get<std::uint32_t>(0);
+			size += put_digits(buffer + size, packed / 512, 4);
+			buffer[size++] = '-';
+			size += put_digits(buffer + size, (packed / 32) % 16, 2);
+			buffer[size++] = '-';
+			size += put_digits(buffer + size, packed % 32, 2);
+			break;
+		}
+		case time : {
+			std::uint32_t seconds = get<std::uint32_t>(0);
+			size += put_digits(buffer + size, seconds / 3600, 2);
+			buffer[size++] = ':';
+			size += put_digits(buffer + size, (seconds / 60) % 60, 2);
+			buffer[size++] = ':';
+			size += put_digits(buffer + size, seconds % 60, 2);
+			break;
+		}
+		case boolean : {
+			std::size_t index = (unsigned char) __bytes[0];
+			const std::list<std::string>& values = (index < sqlType::boolean::true_value.size() ? sqlType::boolean::true_value : sqlType::boolean::false_value);
+			std::list<std::string>::const_iterator it = values.begin();
+			std::advance(it, (index < sqlType::boolean::true_value.size() ? index : index - sqlType::boolean::true_value.size()));
+			std::memcpy(buffer, it->data(), it->size());
+			size = it->size();
+			break;
+		}
+		default :
+			break;
+	}
+	return size;
+}
+
+std::size_t cell::varint_size (std::uint64_t value) throw () {
+	std::size_t size = 1;
+	for (; value >= 0x80; value >>= 7)
+		size++;
+	return size;
+}
+
+static std::size_t encode_varint (char* buffer, std::uint64_t value) {
+	std::size_t size = 0;
+	for (; value >= 0x80; value >>= 7)
+		buffer[size++] = (char) (value | 0x80);
+	buffer[size++] = (char) value;
+	return size;
+}
+
+void cell::put_varint (std::string& buffer, std::uint64_t value) throw () {
+	char bytes[10];
+	buffer.append(bytes, encode_varint(bytes, value));
+}
+
+bool cell::get_varint (const char*& buffer, const char* end, std::uint64_t& value) throw () {
+	value = 0;
+	for (unsigned shift = 0; buffer < end && shift < 64; shift += 7) {
+		unsigned char byte = *buffer++;
+		value |= (std::uint64_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static std::uint64_t zigzag (long long value) {
+	return ((std::uint64_t) value << 1) ^ (std::uint64_t) (value >> 63);
+}
+
+static long long unzigzag (std::uint64_t value) {
+	return (long long) (value >> 1) ^ -(long long) (value & 1);
+}
+
+/* La funzione payload scrive in buffer, che deve contenere almeno 24 byte, la rappresentazione su file del valore nativo: un byte che ne identifica la
+ * rappresentazione seguito dal valore, e ne restituisce la lunghezza. Gli interi sono memorizzati come varint, gli interi con segno dopo la codifica zigzag.
+ */
+std::size_t cell::payload (char* buffer) const throw () {
+	std::size_t size = 0;
+	buffer[size++] = (char) kind();
+	switch (kind()) {
+		case integer :
+			size += encode_varint(buffer + size, zigzag(get<long long>(0)));
+			break;
+		case decimal :
+			buffer[size++] = __bytes[extra];
+			size += encode_varint(buffer + size, zigzag(get<long long>(0)));
+			break;
+		case float32 :
+			buffer[size++] = __bytes[extra];
+			std::memcpy(buffer + size, __bytes, sizeof(float));
+			size += sizeof(float);
+			break;
+		case float64 :
+			buffer[size++] = __bytes[extra];
+			std::memcpy(buffer + size, __bytes, sizeof(double));
+			size += sizeof(double);
+			break;
+		case date_dmy :
+		case date_iso :
+		case time :
+			size += encode_varint(buffer + size, get<std::uint32_t>(0));
+			break;
+		case boolean :
+			buffer[size++] = __bytes[0];
+			break;
+		default :
+			break;
+	}
+	return size;
+}
+
+/* La funzione decode legge la rappresentazione su file scritta da payload. Restituisce false se i byte non sono una rappresentazione valida, comprese una scala
+ * o una precisione che payload non può aver scritto: format le usa per dimensionare la stringa, per cui non devono superare le cifre di un long long o di
+ * un double.
+ */
+bool cell::decode (const char* buffer, std::size_t size) throw () {
+	const char* end = buffer + size;
+	if (size < 1)
+		return false;
+	enum representation form = (enum representation) *buffer++;
+	std::uint64_t value;
+	release();
+	switch (form) {
+		case integer :
+			if (!get_varint(buffer, end, value))
+				return false;
+			set<long long>(0, unzigzag(value));
+			break;
+		case decimal :
+			if (buffer == end || (unsigned char) *buffer > 18)
+				return false;
+			__bytes[extra] = *buffer++;
+			if (!get_varint(buffer, end, value))
+				return false;
+			set<long long>(0, unzigzag(value));
+			break;
+		case float32 :
+		case float64 : {
+			std::size_t bytes = (form == float32 ? sizeof(float) : sizeof(double));
+			if ((std::size_t) (end - buffer) != bytes + 1 || *buffer < 1 || *buffer > (form == float32 ? 9 : 17))
+				return false;
+			__bytes[extra] = *buffer++;
+			std::memcpy(__bytes, buffer, bytes);
+			buffer += bytes;
+			break;
+		}
+		case date_dmy :
+		case date_iso :
+		case time :
+			if (!get_varint(buffer, end, value) || value > 0xffffffffULL)
+				return false;
+			set<std::uint32_t>(0, (std::uint32_t) value);
+			break;
+		case boolean :
+			if (buffer == end || (unsigned char) *buffer >= sqlType::boolean::true_value.size() + sqlType::boolean::false_value.size())
+				return false;
+			__bytes[0] = *buffer++;
+			break;
+		default :
+			return false;
+	}
+	if (buffer != end)
+		return false;
+	__tag = form;
+	return true;
+}
+
+std::size_t cell::size () const throw () {
+	if (!native())
+		return varint_size((std::uint64_t) length() << 1) + length();
+	char buffer[24];
+	std::size_t size = payload(buffer);
+	return varint_size(((std::uint64_t) size << 1) | 1) + size;
+}
+
+void cell::write (std::string& buffer) const throw () {
+	if (!native()) {
+		put_varint(buffer, (std::uint64_t) length() << 1);
+		buffer.append(data(), length());
+	}
+	else {
+		char bytes[24];
+		std::size_t size = payload(bytes);
+		put_varint(buffer, ((std::uint64_t) size << 1) | 1);
+		buffer.append(bytes, size);
+	}
+}
+
+bool cell::read (const char*& buffer, const char* end, bool tagged) throw () {
+	std::uint64_t header;
+	if (!get_varint(buffer, end, header))
+		return false;
+	std::uint64_t size = (tagged ? header >> 1 : header);
+	if (size > (std::uint64_t) (end - buffer))
+		return false;
+	if (tagged && (header & 1)) {
+		if (!decode(buffer, size))
+			return false;
+	}
+	else
+		assign_text(buffer, size);
+	buffer += size;
+	return true;
+}
+
+bool cell::read (const char*& buffer, const char* end, bool tagged, std::string& value) throw () {
+	std::uint64_t header;
+	if (!get_varint(buffer, end, header))
+		return false;
+	std::uint64_t size = (tagged ? header >> 1 : header);
+	if (size > (std::uint64_t) (end - buffer))
+		return false;
+	if (tagged && (header & 1)) {
+		cell _cell;
+		if (!_cell.decode(buffer, size))
+			return false;
+		value.clear();
+		_cell.append(value);
+	}
+	else
+		value.assign(buffer, size);
+	buffer += size;
+	return true;
+}
+
+bool cell::skip (const char*& buffer, const char* end, bool tagged) throw () {
+	std::uint64_t header;
+	if (!get_varint(buffer, end, header))
+		return false;
+	std::uint64_t size = (tagged ? header >> 1 : header);
+	if (size > (std::uint64_t) (end - buffer))
+		return false;
+	buffer += size;
+	return true;
+}
+
+void cell::write (std::string& buffer, const std::string& value, enum sqlType::native_type type) throw () {
+	if (type == sqlType::as_text) {
+		put_varint(buffer, (std::uint64_t) value.size() << 1);
+		buffer.append(value);
+	}
+	else {
+		cell _cell;
+		_cell.assign(value, type);
+		_cell.write(buffer);
+	}
+}
@@ -0,0 +1,190 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OPENDB_CELL_HEADER__
+#define __OPENDB_CELL_HEADER__
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include "sqlType.hpp"
+
+namespace openDB {
+class arena;
+
+/* La classe field consente di leggere il valore di una cella senza copiarlo (vedi cell::view e record::current): se la cella contiene una stringa, field
+ * ne espone direttamente i caratteri; se il valore è in forma nativa, viene convertito in stringa in un buffer interno. Un oggetto field non alloca mai
+ * memoria e resta valido finché la cella da cui è stato letto non viene modificata o distrutta.
+ */
+class field {
+public:
+		field () throw () : __data(__buffer), __size(0) {}
+		field (const field& _field) throw () : __size(_field.__size)
+				{copy(_field);}
+		field& operator= (const field& _field) throw ()
+				{if (this != &_field) {__size = _field.__size; copy(_field);} return *this;}
+
+		const char* data () const throw ()
+				{return __data;}
+		std::size_t size () const throw ()
+				{return __size;}
+		bool empty () const throw ()
+				{return __size == 0;}
+
+		/* La funzione str restituisce una copia del valore, la funzione append lo accoda a value. */
+		std::string str () const throw ()
+				{return std::string(__data, __size);}
+		void append (std::string& value) const throw ()
+				{value.append(__data, __size);}
+
+		bool operator== (const field& _field) const throw ()
+				{return __size == _field.__size && std::memcmp(__data, _field.__data, __size) == 0;}
+		bool operator!= (const field& _field) const throw ()
+				{return !(*this == _field);}
+		bool operator== (const std::string& value) const throw ()
+				{return __size == value.size() && std::memcmp(__data, value.data(), __size) == 0;}
+		bool operator!= (const std::string& value) const throw ()
+				{return !(*this == value);}
+
+private:
+		friend class cell;
+		const char*		__data;
+		std::size_t		__size;
+		char			__buffer[64];
+
+		void copy (const field& _field) throw ()
+				{if (_field.__data == _field.__buffer) {std::memcpy(__buffer, _field.__buffer, __size); __data = __buffer;} else __data = _field.__data;}
+};
+
+/* La classe cell contiene il valore di una colonna all'interno di una tupla (vedi record.hpp) ed occupa 16 byte, la metà di un oggetto std::string.
+ * Il valore può essere memorizzato:
+ * 	- come stringa: fino a 15 caratteri vengono memorizzati all'interno dell'oggetto stesso, oltre in un blocco allocato dinamicamente;
+ * 	- nella rappresentazione nativa del tipo della colonna (vedi sqlType::native_type): un intero, un numero in virgola mobile, un decimale scalato, una
+ * 	  data, un orario o un valore booleano compattati in pochi byte.
+ * Il valore viene riconvertito in stringa soltanto quando viene letto (vedi text), per cui la rappresentazione nativa viene usata solo se la conversione
+ * restituisce esattamente la stringa originale: "007", "-0" o "+1" restano stringhe, ad esempio, perché diventerebbero "7", "0" e "1", mentre "1.50" viene
+ * memorizzato come decimale con due cifre dopo la virgola e riconvertito in "1.50". In questo modo i valori restituiti dalle tuple ed i comandi sql
+ * generati a partire da essi non cambiano.
+ * Le stringhe più lunghe di 15 caratteri possono essere allocate in un oggetto arena (vedi arena.hpp) anziché singolarmente, o condivise con un dizionario
+ * (vedi dictionary.hpp): in tal caso la cella non ne è proprietaria e non deve sopravvivere all'arena o al dizionario; la copia di una cella, invece, alloca
+ * sempre una nuova stringa.
+ */
+class cell {
+public:
+		cell () throw () : __tag(local_text) {}
+		cell (const cell& _cell) throw ();
+		cell (cell&& _cell) throw ();
+		~cell () throw ()
+				{release();}
+		cell& operator= (const cell& _cell) throw ();
+		cell& operator= (cell&& _cell) throw ();
+
+		/* La funzione assign memorizza il valore value, nella rappresentazione nativa type se possibile, altrimenti come stringa. Se _arena non è nullo, le
+		 * stringhe che non possono essere memorizzate all'interno della cella vengono allocate nell'arena.
+		 */
+		void assign (const std::string& value, enum sqlType::native_type type = sqlType::as_text, arena* _arena = 0) throw ();
+
+		/* La funzione share memorizza un riferimento alla stringa value, che deve sopravvivere alla cella; le stringhe che possono essere memorizzate
+		 * all'interno della cella vengono invece copiate.
+		 */
+		void share (const std::string& value) throw ();
+
+		/* La funzione alias rende la cella una copia di _cell che, se il valore è una stringa allocata dinamicamente, non ne è proprietaria: _cell deve
+		 * sopravvivere alla cella e non deve essere modificata finchè la cella viene usata (vedi column_storage.hpp).
+		 */
+		void alias (const cell& _cell) throw ();
+
+		/* La funzione text restituisce il valore come stringa, la funzione append lo accoda a value, la funzione view lo espone attraverso _field senza
+		 * copiarlo (vedi field).
+		 */
+		std::string text () const throw ();
+		void append (std::string& value) const throw ();
+		void view (field& _field) const throw ();
+
+		/* La funzione empty restituisce true se la cella contiene una stringa vuota, la funzione native se il valore è memorizzato in forma nativa.
+		 */
+		bool empty () const throw ()
+				{return __tag == local_text;}
+		bool native () const throw ()
+				{return kind() > heap_text && kind() < shared_text;}
+
+		/* La funzione heap restituisce il numero di byte allocati dinamicamente dalla cella.
+		 */
+		std::size_t heap () const throw ()
+				{return (kind() == heap_text ? length() : 0);}
+
+		/* Le funzioni seguenti serializzano la cella all'interno di una tupla (vedi record.cpp). Ogni valore è preceduto dalla sua lunghezza, un intero di
+		 * lunghezza variabile (varint); se tagged è true il bit meno significativo della lunghezza indica che il valore è in forma nativa, nel qual caso il primo
+		 * byte del valore ne identifica la rappresentazione. Se tagged è false, come nelle tuple scritte dalle versioni precedenti, il valore è una stringa.
+		 * 	- size restituisce il numero di byte necessari a serializzare la cella;
+		 * 	- write accoda la cella al buffer;
+		 * 	- read legge una cella a partire da buffer, spostandolo oltre la cella; restituisce false se i byte compresi tra buffer ed end non contengono una
+		 * 	  cella valida;
+		 * 	- la versione statica di read legge il valore direttamente come stringa, skip lo salta senza leggerlo;
+		 * 	- la versione statica di write serializza il valore value esattamente come farebbe una cella costruita con assign.
+		 */
+		std::size_t size () const throw ();
+		void write (std::string& buffer) const throw ();
+		bool read (const char*& buffer, const char* end, bool tagged) throw ();
+		static bool read (const char*& buffer, const char* end, bool tagged, std::string& value) throw ();
+		static bool skip (const char*& buffer, const char* end, bool tagged) throw ();
+		static void write (std::string& buffer, const std::string& value, enum sqlType::native_type type) throw ();
+
+		/* Funzioni di utilità per la codifica degli interi di lunghezza variabile, usate anche dalla serializzazione delle tuple */
+		static std::size_t varint_size (std::uint64_t value) throw ();
+		static void put_varint (std::string& buffer, std::uint64_t value) throw ();
+		static bool get_varint (const char*& buffer, const char* end, std::uint64_t& value) throw ();
+
+		/* Numero massimo di caratteri di una stringa memorizzata all'interno della cella */
+		static const std::size_t local_size = 15;
+
+private:
+		/* Rappresentazioni possibili del valore, memorizzate nei quattro bit meno significativi di __tag. I quattro bit più significativi contengono la
+		 * lunghezza di una stringa memorizzata all'interno della cella. Per le altre rappresentazioni __bytes contiene:
+		 * 	- heap_text : l'indirizzo del blocco allocato e, a partire dall'ottavo byte, la sua lunghezza;
+		 * 	- integer, decimal : l'intero a 64 bit e, per decimal, nell'ottavo byte il numero di cifre decimali;
+		 * 	- float32, float64 : il numero e, nell'ottavo byte, il numero di cifre significative con cui era espresso;
+		 * 	- date_dmy, date_iso : la data compattata in un intero a 32 bit (anno * 512 + mese * 32 + giorno), nel formato gg/mm/aaaa o aaaa-mm-gg;
+		 * 	- time : il numero di secondi dalla mezzanotte;
+		 * 	- boolean : l'indice della stringa in sqlType::boolean::true_value, o in false_value aumentato di true_value.size();
+		 * 	- shared_text : come heap_text, ma il blocco appartiene ad un oggetto arena o ad un dizionario e non viene deallocato dalla cella.
+		 * Le rappresentazioni native vengono anche scritte su file (vedi payload), per cui eventuali nuove rappresentazioni vanno aggiunte in coda.
+		 */
+		enum representation {local_text, heap_text, integer, float32, float64, decimal, date_dmy, date_iso, time, boolean, shared_text};
+		static const std::size_t extra = 8;
+
+		char				__bytes[local_size];
+		unsigned char		__tag;
+
+		enum representation kind () const throw ()
+				{return (enum representation) (__tag & 0x0f);}
+		bool external () const throw ()
+				{return kind() == heap_text || kind() == shared_text;}
+		std::size_t length () const throw ()
+				{return (external() ? get<std::uint32_t>(extra) : __tag >> 4);}
+		const char* data () const throw ()
+				{return (external() ? get<char*>(0) : __bytes);}
+
+		template <typename T> T get (std::size_t offset) const throw ()
+				{T value; std::memcpy(&value, __bytes + offset, sizeof(T)); return value;}
+		template <typename T> void set (std::size_t offset, T value) throw ()
+				{std::memcpy(__bytes + offset, &value, sizeof(T));}
+
+		void release () throw ();
+		void assign_text (const char* value, std::size_t size, arena* _arena = 0) throw ();
+		bool encode (const std::string& value, enum sqlType::native_type type) throw ();
+		std::size_t format (char* buffer) const throw ();
+		std::size_t payload (char* buffer) const throw ();
+		bool decode (const char* buffer, std::size_t size) throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
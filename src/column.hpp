@@ -70,6 +70,11 @@ public:
 		struct sqlType::type_info get_type_info() const throw()
 			{return __columnType->get_type_info();}
 
+		/* La funzione native restituisce la rappresentazione binaria con cui i valori della colonna vengono memorizzati nelle tuple (vedi cell.hpp).
+		 */
+		enum sqlType::native_type native() const throw()
+			{return __columnType->native();}
+
 		/* Il compito della funzione validate_value è quello di verificare che un valore, rappresentato dalla stringa value, possa essere tradotto senza errori da un tipo di dato
 		 * sql specifico al suo omologo nella trasposizione in linguaggio c++. Nel caso in cui durante la "traduzione" si verifichi un errore oppure nel caso in cui tale traduzione
 		 * non sia possibile, viene generata una eccezione di tipo data_exception (vedi header exception.hpp) o derivati.
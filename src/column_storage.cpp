@@ -0,0 +1,301 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "column_storage.hpp"
+#include <algorithm>
+using namespace openDB;
+
+std::unique_ptr<std::list<unsigned long>> column_storage::internalID () const throw () {
+	std::unique_ptr<std::list<unsigned long>> list_ptr (new std::list<unsigned long>);
+	for (unsigned long ID = 0; ID < __descriptors.size(); ID++)
+		if (__descriptors[ID])
+			list_ptr->push_back(ID);
+	return list_ptr;
+}
+
+void column_storage::clear () throw () {
+	// le colonne vengono svuotate prima del dizionario, con cui condividono i valori
+	std::vector<column_data>().swap(__columns);
+	__columnIndex.clear();
+	std::vector<const record::descriptor*>().swap(__descriptors);
+	std::vector<unsigned char>().swap(__states);
+	std::vector<bool>().swap(__visible);
+	std::vector<bool>().swap(__updated);
+	__layouts.clear();
+	__dictionary.clear();
+	__pending.clear();
+	__records = 0;
+	__lastKey = 0;
+}
+
+void column_storage::begin_bulk (unsigned long records) throw () {
+	std::size_t size = __descriptors.size() + records;
+	__descriptors.reserve(size);
+	__states.reserve(size);
+	__visible.reserve(size);
+	__updated.reserve(size);
+	for (std::vector<column_data>::iterator it = __columns.begin(); it != __columns.end(); it++) {
+		it->values.reserve(size);
+		it->present.reserve(size);
+	}
+}
+
+unsigned long column_storage::insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) {
+	record _record(valuesMap, columnsMap, _state, 0, (__encode ? &__dictionary : 0));
+	unsigned long ID = append();
+	place(ID, _record);
+	return ID;
+}
+
+unsigned long column_storage::insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) {
+	unsigned long first = __lastKey;
+	const std::vector<std::size_t>& _layout = layout(_batch.__descriptor);
+	std::vector<std::string> validated;
+	for (std::size_t row = 0; row < _batch.rows(); row++) {
+		if (_state != record::loaded) {		//i valori vengono validati prima di aggiungere il record
+			validated.clear();
+			for (std::size_t i = 0; i < _batch.__columns.size(); i++)
+				validated.push_back(_batch.__columns[i]->validate_value((*_batch.__values[i])[row]));
+		}
+		unsigned long ID = append();
+		for (std::size_t i = 0; i < _layout.size(); i++) {
+			column_data& data = __columns[_layout[i]];
+			record::assign_value(data.values[ID], data.name, (_state != record::loaded ? validated[i] : (*_batch.__values[i])[row]), *_batch.__columns[i], 0, (__encode ? &__dictionary : 0));
+			data.present[ID] = true;
+		}
+		__descriptors[ID] = _batch.__descriptor;
+		__states[ID] = _state;
+		__visible[ID] = (_state != record::deleting);
+		track(ID, _state);
+	}
+	return first;
+}
+
+void column_storage::update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) {
+	record _record;
+	take(slot(ID), _record);
+	try {
+		_record.update(valuesMap, columnsMap, (__encode ? &__dictionary : 0));
+	}
+	catch (...) {
+		place(ID, _record);
+		throw;
+	}
+	place(ID, _record);
+}
+
+void column_storage::cancel (unsigned long ID) throw (storage_exception&) {
+	__states[slot(ID)] = record::deleting;
+	__visible[ID] = false;
+	track(ID, record::deleting);
+}
+
+void column_storage::erase (unsigned long ID) throw (storage_exception&) {
+	record _record;
+	take(slot(ID), _record);
+	__descriptors[ID] = 0;
+	__records--;
+	untrack(ID);
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> column_storage::current(unsigned long ID) const throw (storage_exception&) {
+	const std::vector<std::size_t>& _layout = layout(__descriptors[slot(ID)]);
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+	for (std::size_t i = 0; i < _layout.size(); i++)
+		map_ptr->insert(std::pair<std::string, std::string>(__columns[_layout[i]].name, __columns[_layout[i]].values[ID].text()));
+	return map_ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> column_storage::old(unsigned long ID) const throw (storage_exception&) {
+	const std::vector<std::size_t>& _layout = layout(__descriptors[slot(ID)]);
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+	for (std::size_t i = 0; i < _layout.size(); i++) {
+		const column_data& data = __columns[_layout[i]];
+		std::unordered_map<unsigned long, cell>::const_iterator old_it = (__updated[ID] ? data.old.find(ID) : data.old.end());
+		map_ptr->insert(std::pair<std::string, std::string>(data.name, (old_it != data.old.end() ? old_it->second.text() : std::string())));
+	}
+	return map_ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> column_storage::current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&) {
+	slot(ID);
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+	for (std::list<std::string>::const_iterator it = columns.begin(); it != columns.end(); it++) {
+		std::unordered_map<std::string, std::size_t>::const_iterator index_it = __columnIndex.find(*it);
+		if (index_it != __columnIndex.end() && __columns[index_it->second].present[ID])
+			map_ptr->insert(std::pair<std::string, std::string>(*it, __columns[index_it->second].values[ID].text()));
+	}
+	return map_ptr;
+}
+
+void column_storage::scan (visitor& _visitor) const throw (basic_exception&) {
+	visit_range(0, __descriptors.size(), _visitor);
+}
+
+void column_storage::visit_morsel (std::size_t morsel, visitor& _visitor) const throw (basic_exception&) {
+	visit_range(morsel * morsel_rows, std::min<unsigned long>((morsel + 1) * morsel_rows, __descriptors.size()), _visitor);
+}
+
+void column_storage::visit_range (unsigned long first, unsigned long last, visitor& _visitor) const throw (basic_exception&) {
+	record _record;		//il record viene ricomposto, per ciascuna chiave, riutilizzando le stesse celle
+	const record::descriptor* _descriptor = 0;
+	const std::vector<std::size_t>* _layout = 0;
+	for (unsigned long ID = first; ID < last; ID++)
+		if (__descriptors[ID]) {
+			if (__descriptors[ID] != _descriptor) {
+				_descriptor = __descriptors[ID];
+				_layout = &layout(_descriptor);
+			}
+			assemble(ID, *_layout, _record);
+			_visitor.visit(ID, _record);
+		}
+}
+
+void column_storage::scan (const std::vector<std::string>& columns, column_visitor& _visitor) const throw (basic_exception&) {
+	std::vector<const column_data*> data(columns.size(), 0);
+	for (std::size_t i = 0; i < columns.size(); i++) {
+		std::unordered_map<std::string, std::size_t>::const_iterator index_it = __columnIndex.find(columns[i]);
+		if (index_it != __columnIndex.end())
+			data[i] = &__columns[index_it->second];
+	}
+	std::vector<field> values(columns.size());
+	std::vector<bool> present(columns.size());
+	for (unsigned long ID = 0; ID < __descriptors.size(); ID++) {
+		if (!__descriptors[ID])
+			continue;
+		for (std::size_t i = 0; i < data.size(); i++)
+			if ((present[i] = (data[i] && data[i]->present[ID])))
+				data[i]->values[ID].view(values[i]);
+			else
+				values[i] = field();
+		_visitor.visit(ID, values, present);
+	}
+}
+
+void column_storage::visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&) {
+	record _record;
+	unsigned long slot_ID = slot(ID);
+	assemble(slot_ID, layout(__descriptors[slot_ID]), _record);
+	_visitor.visit(ID, _record);
+}
+
+bool column_storage::slot_cursor::next () throw () {
+	const column_storage& _storage = static_cast<const column_storage&>(__storage);
+	while (__next < _storage.__descriptors.size() && !_storage.__descriptors[__next])
+		__next++;
+	if (__next == _storage.__descriptors.size())
+		return false;
+	__ID = __next++;
+	return true;
+}
+
+unsigned long column_storage::slot (unsigned long ID) const throw (storage_exception&) {
+	if (ID >= __descriptors.size() || !__descriptors[ID])
+		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
+	return ID;
+}
+
+const std::vector<std::size_t>& column_storage::layout (const record::descriptor* _descriptor) throw () {
+	std::unordered_map<const record::descriptor*, std::vector<std::size_t>>::iterator it = __layouts.find(_descriptor);
+	if (it != __layouts.end())
+		return it->second;
+	std::vector<std::size_t>& _layout = __layouts[_descriptor];
+	for (std::size_t i = 0; i < _descriptor->size(); i++) {
+		std::unordered_map<std::string, std::size_t>::const_iterator index_it = __columnIndex.find(_descriptor->name(i));
+		if (index_it == __columnIndex.end()) {		//nuova colonna, vuota in tutti i record esistenti
+			index_it = __columnIndex.insert(std::pair<std::string, std::size_t>(_descriptor->name(i), __columns.size())).first;
+			__columns.push_back(column_data());
+			__columns.back().name = _descriptor->name(i);
+			__columns.back().values.resize(__descriptors.size());
+			__columns.back().present.resize(__descriptors.size(), false);
+		}
+		_layout.push_back(index_it->second);
+	}
+	return _layout;
+}
+
+const std::vector<std::size_t>& column_storage::layout (const record::descriptor* _descriptor) const throw () {
+	return __layouts.find(_descriptor)->second;
+}
+
+unsigned long column_storage::append () throw () {
+	for (std::vector<column_data>::iterator it = __columns.begin(); it != __columns.end(); it++) {
+		it->values.push_back(cell());
+		it->present.push_back(false);
+	}
+	__descriptors.push_back(0);
+	__states.push_back(record::empty);
+	__visible.push_back(false);
+	__updated.push_back(false);
+	__records++;
+	return __lastKey++;
+}
+
+void column_storage::place (unsigned long ID, record& _record) throw () {
+	const std::vector<std::size_t>& _layout = layout(_record.__descriptor);
+	for (std::size_t i = 0; i < _layout.size(); i++) {
+		column_data& data = __columns[_layout[i]];
+		data.values[ID] = std::move(_record.__current[i]);
+		data.present[ID] = true;
+		if (!_record.__old.empty() && !_record.__old[i].empty()) {
+			data.old[ID] = std::move(_record.__old[i]);
+			__updated[ID] = true;
+		}
+	}
+	__descriptors[ID] = _record.__descriptor;
+	__states[ID] = _record.__state;
+	__visible[ID] = _record.__visible;
+	track(ID, _record.__state);
+}
+
+void column_storage::take (unsigned long ID, record& _record) throw () {
+	const std::vector<std::size_t>& _layout = layout(__descriptors[ID]);
+	_record.__descriptor = __descriptors[ID];
+	_record.__state = (enum record::state) __states[ID];
+	_record.__visible = __visible[ID];
+	_record.__current.resize(_layout.size());
+	_record.__old.clear();
+	if (__updated[ID])
+		_record.__old.resize(_layout.size());
+	for (std::size_t i = 0; i < _layout.size(); i++) {
+		column_data& data = __columns[_layout[i]];
+		_record.__current[i] = std::move(data.values[ID]);
+		data.present[ID] = false;
+		std::unordered_map<unsigned long, cell>::iterator old_it = (__updated[ID] ? data.old.find(ID) : data.old.end());
+		if (old_it != data.old.end()) {
+			_record.__old[i] = std::move(old_it->second);
+			data.old.erase(old_it);
+		}
+	}
+	__updated[ID] = false;
+}
+
+void column_storage::assemble (unsigned long ID, const std::vector<std::size_t>& _layout, record& _record) const throw () {
+	_record.__descriptor = __descriptors[ID];
+	_record.__state = (enum record::state) __states[ID];
+	_record.__visible = __visible[ID];
+	_record.__current.resize(_layout.size());
+	if (__updated[ID])
+		_record.__old.resize(_layout.size());
+	else
+		_record.__old.clear();
+	for (std::size_t i = 0; i < _layout.size(); i++) {
+		const column_data& data = __columns[_layout[i]];
+		_record.__current[i].alias(data.values[ID]);
+		if (__updated[ID]) {
+			std::unordered_map<unsigned long, cell>::const_iterator old_it = data.old.find(ID);
+			if (old_it != data.old.end())
+				_record.__old[i].alias(old_it->second);
+			else
+				_record.__old[i] = cell();
+		}
+	}
+}
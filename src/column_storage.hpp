@@ -0,0 +1,134 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_COLUMN_STORAGE_HEADER__
+#define __OPENDB_COLUMN_STORAGE_HEADER__
+
+#include "storage.hpp"
+#include "dictionary.hpp"
+
+namespace openDB{
+/* La classe column_storage mantiene i record in memoria, come memory_storage, ma scomposti per colonna: i valori di ciascuna colonna sono memorizzati in un
+ * vettore contiguo di celle (vedi cell.hpp), nella rappresentazione nativa del tipo della colonna quando possibile, indicizzato dalla chiave del record. Lo
+ * stato, la visibilità e il descrittore (vedi record::descriptor) di ciascun record sono memorizzati in vettori separati, e un vettore di bit per colonna
+ * indica quali record contengono un valore per quella colonna. I valori precedenti, presenti solo nei record aggiornati, sono memorizzati a parte.
+ * La lettura di poche colonne di molti record (vedi storage::column_visitor) scorre soltanto i vettori di quelle colonne, senza accedere agli altri valori;
+ * le funzioni che operano su un singolo record, come current o update, lo ricompongono a partire dalle colonne. La funzione scan, in particolare, passa al
+ * visitatore un record i cui valori non vengono copiati.
+ * Le chiavi non vengono riutilizzate: lo spazio dei record rimossi da erase viene recuperato soltanto dalla funzione clear.
+ * I valori delle colonne varchar e character possono essere codificati con un dizionario (vedi dictionary.hpp), come in memory_storage. I valori del
+ * dizionario vengono liberati soltanto dalla funzione clear, anche quando i record che li usano vengono modificati o rimossi, per cui la codifica è indicata
+ * soltanto per le tabelle che vengono caricate una volta e poi lette.
+ */
+class column_storage : public storage {
+public:
+		/* Il parametro encode stabilisce se i valori testuali vengono codificati con il dizionario.
+		 */
+		column_storage(bool encode = false) throw () : storage(), __encode(encode), __records(0) {}
+
+		/* Vedi storage.hpp.
+		 */
+		virtual std::unique_ptr<std::list<unsigned long>> internalID () const throw ();
+		virtual unsigned long numRecords () const throw ()
+				{return __records;}
+		virtual void clear () throw ();
+		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&);
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&);
+		virtual void update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&);
+		virtual void cancel (unsigned long ID) throw (storage_exception&);
+		virtual void erase (unsigned long ID) throw (storage_exception&);
+		virtual enum record::state state (unsigned long ID) const throw (storage_exception&)
+				{return (enum record::state) __states[slot(ID)];}
+		virtual bool visible (unsigned long ID)	const throw (storage_exception&)
+				{return __visible[slot(ID)];}
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&);
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&);
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&);
+		virtual void scan (visitor& _visitor) const throw (basic_exception&);
+		virtual void scan (const std::vector<std::string>& columns, column_visitor& _visitor) const throw (basic_exception&);
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&);
+		virtual std::unique_ptr<cursor> rows () const throw ()
+				{return std::unique_ptr<cursor>(new slot_cursor(*this));}
+
+		/* La funzione begin_bulk riserva spazio per records record in ciascun vettore. */
+		virtual void begin_bulk (unsigned long records) throw ();
+
+		virtual std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>> dictionary_stats () const throw ()
+				{return __dictionary.stats();}
+
+private:
+		/* I valori di una colonna: values[ID] è il valore della colonna nel record con chiave ID, significativo solo se present[ID] è true; old contiene i
+		 * valori precedenti non vuoti dei record aggiornati.
+		 */
+		struct column_data {
+				std::string									name;
+				std::vector<cell>							values;
+				std::vector<bool>							present;
+				std::unordered_map<unsigned long, cell>		old;
+		};
+
+		bool												__encode;
+
+		/* Il dizionario deve essere dichiarato prima delle colonne, in modo da essere distrutto dopo di esse. */
+		dictionary											__dictionary;
+		std::vector<column_data>							__columns;
+		std::unordered_map<std::string, std::size_t>		__columnIndex;
+
+		/* Vettori indicizzati dalla chiave del record: il descrittore, nullo se il record è stato rimosso, lo stato, la visibilità e la presenza di valori
+		 * precedenti.
+		 */
+		std::vector<const record::descriptor*>				__descriptors;
+		std::vector<unsigned char>							__states;
+		std::vector<bool>									__visible;
+		std::vector<bool>									__updated;
+		unsigned long										__records;
+
+		/* Per ciascun descrittore utilizzato, la colonna in cui è memorizzato il valore in ciascuna posizione del descrittore. */
+		std::unordered_map<const record::descriptor*, std::vector<std::size_t>>	__layouts;
+
+		/* Il cursore scorre le chiavi in ordine crescente, saltando quelle dei record rimossi. */
+		class slot_cursor : public cursor {
+		public :
+				explicit slot_cursor (const column_storage& _storage) throw () : cursor(_storage), __next(0) {}
+				virtual bool next () throw ();
+		private :
+				unsigned long	__next;
+		};
+
+		/* I blocchi visitati da parallel_scan (vedi storage.hpp) sono intervalli di morsel_rows chiavi consecutive. La funzione visit_range visita i record
+		 * con chiave compresa tra first (incluso) e last (escluso), come la funzione scan.
+		 */
+		virtual std::size_t morsels () const throw ()
+				{return (__descriptors.size() + morsel_rows - 1) / morsel_rows;}
+		virtual void visit_morsel (std::size_t morsel, visitor& _visitor) const throw (basic_exception&);
+		void visit_range (unsigned long first, unsigned long last, visitor& _visitor) const throw (basic_exception&);
+
+		/* La funzione slot verifica che ID sia la chiave di un record esistente e la restituisce; in caso contrario viene generata una eccezione di tipo
+		 * record_not_exists.
+		 * La prima versione della funzione layout restituisce la corrispondenza tra le posizioni del descrittore e le colonne, creando le colonne ancora
+		 * inesistenti; la seconda può essere usata solo per i descrittori dei record memorizzati.
+		 */
+		unsigned long slot (unsigned long ID) const throw (storage_exception&);
+		const std::vector<std::size_t>& layout (const record::descriptor* _descriptor) throw ();
+		const std::vector<std::size_t>& layout (const record::descriptor* _descriptor) const throw ();
+
+		/* La funzione append aggiunge in coda ai vettori un record vuoto e ne restituisce la chiave. La funzione place memorizza nelle colonne il contenuto di
+		 * _record, spostandone i valori, nella posizione ID, che non deve contenere valori; la funzione take fa l'opposto, spostando i valori del record ID
+		 * in _record. La funzione assemble ricompone il record ID, le cui colonne sono indicate da _layout, in _record senza copiarne i valori (vedi
+		 * cell::alias): _record resta valido finchè il record non viene modificato.
+		 */
+		unsigned long append () throw ();
+		void place (unsigned long ID, record& _record) throw ();
+		void take (unsigned long ID, record& _record) throw ();
+		void assemble (unsigned long ID, const std::vector<std::size_t>& _layout, record& _record) const throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
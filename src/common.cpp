@@ -11,6 +11,7 @@
  */
 
 #include "common.hpp"
+#include <cstring>
 
 
 std::unique_ptr<std::list <std::string>> openDB::tokenize (std::string _string, char sep) throw () {
@@ -96,3 +97,22 @@ void openDB::read (std::fstream& stream, std::list <std::string>& _list) throw (
 		_list.push_back(_string);
 	}
 }
+
+void openDB::write (std::string& buffer, const std::string& _string) throw () {
+	unsigned length = _string.size();
+	buffer.append(reinterpret_cast <const char*> (&length), sizeof (unsigned));
+	buffer.append(_string);
+}
+
+bool openDB::read (const char*& buffer, const char* end, std::string& _string) throw () {
+	unsigned length;
+	if (end - buffer < (std::ptrdiff_t) sizeof (unsigned))
+		return false;
+	std::memcpy(&length, buffer, sizeof (unsigned));
+	buffer += sizeof (unsigned);
+	if (end - buffer < (std::ptrdiff_t) length)
+		return false;
+	_string.assign(buffer, length);
+	buffer += length;
+	return true;
+}
@@ -35,5 +35,13 @@ void read (std::fstream& stream, std::string& _string) throw ();
  */
 void write (std::fstream& stream, const std::list <std::string>& _list) throw ();
 void read (std::fstream& stream, std::list <std::string>& _list) throw ();
+
+/* Le seguenti sono le omologhe delle precedenti, ma operano su un buffer in memoria anziché su uno stream, in modo che un record possa essere serializzato
+ * interamente prima di essere scritto su file con una singola operazione di I/O posizionale.
+ * La funzione write accoda la stringa _string al buffer. La funzione read legge una stringa a partire dalla posizione puntata da buffer, senza superare end, e
+ * sposta buffer oltre i byte letti; restituisce false se i dati contenuti nel buffer non sono sufficienti.
+ */
+void write (std::string& buffer, const std::string& _string) throw ();
+bool read (const char*& buffer, const char* end, std::string& _string) throw ();
 };
 #endif
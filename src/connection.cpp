@@ -11,6 +11,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include "connection.hpp"
+#include <algorithm>
 using namespace openDB;
 
 void connection::connect () throw (remote_exception&) {
@@ -61,14 +62,21 @@ std::unique_ptr<table> connection::process_result(unsigned long queryID, PGresul
 		table_ptr->load(tmp);
 	}
 	else {
-		for (int col = 0; col < num_columns(pgresult); col++) //creazione delle colonne
-			table_ptr->add_column(column_name(pgresult, col), new sqlType::varchar);
+		std::vector<std::string> columns;
+		for (int col = 0; col < num_columns(pgresult); col++) { //creazione delle colonne
+			columns.push_back(column_name(pgresult, col));
+			table_ptr->add_column(columns.back(), new sqlType::varchar);
+		}
 
-		for (int row = 0; row < num_tuples(pgresult); row++) { //riempimento delle tuple
-			std::unordered_map<std::string, std::string> tmp;
-			for (int col = 0; col < num_columns(pgresult); col++) //creazione della mappa per l'inserimento di una tupla
-				tmp.insert(std::pair<std::string, std::string>(column_name(pgresult, col), value(pgresult, row, col)));
-			table_ptr->load(tmp);
+		std::vector<std::vector<std::string>> values(columns.size());
+		for (int first = 0; first < num_tuples(pgresult); first += record::batch::default_rows) { //riempimento delle tuple, a blocchi, colonna per colonna
+			int last = std::min(num_tuples(pgresult), first + (int) record::batch::default_rows);
+			for (int col = 0; col < num_columns(pgresult); col++) {
+				values[col].resize(last - first);
+				for (int row = first; row < last; row++)
+					values[col][row - first].assign(PQgetvalue(pgresult, row, col), PQgetlength(pgresult, row, col));
+			}
+			table_ptr->load(columns, values);
 		}
 	}
 	return table_ptr;
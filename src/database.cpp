@@ -29,6 +29,7 @@ const std::string database::__tmpStorageDirectory = "platinet";
 const std::string database::__other_column = "select col.table_schema,col.table_name,col.column_name,col.udt_name,col.character_maximum_length,col.numeric_precision,col.numeric_scale from information_schema.columns col where col.table_schema not in('pg_catalog', 'information_schema') and (col.table_schema, col.table_name, col.column_name) not in (select col.table_schema, col.table_name, col.column_name from information_schema.columns col join information_schema.constraint_column_usage ccl on col.table_schema=ccl.table_schema and col.table_name=ccl.table_name and col.column_name=ccl.column_name join information_schema.table_constraints ts on ccl.constraint_name=ts.constraint_name where ts.constraint_type = 'PRIMARY KEY' and col.table_schema not in ('pg_catalog','information_schema')) order by col.table_schema,col.table_name, col.ordinal_position";
 const std::string database::__key_column  = "select col.table_schema,col.table_name,col.column_name,col.udt_name,col.character_maximum_length,col.numeric_precision,col.numeric_scale from information_schema.columns col where col.table_schema not in('pg_catalog', 'information_schema') and (col.table_schema, col.table_name, col.column_name) in (select col.table_schema, col.table_name, col.column_name from information_schema.columns col join information_schema.constraint_column_usage ccl on col.table_schema=ccl.table_schema and col.table_name=ccl.table_name and col.column_name=ccl.column_name join information_schema.table_constraints ts on ccl.constraint_name=ts.constraint_name where ts.constraint_type = 'PRIMARY KEY' and col.table_schema not in ('pg_catalog','information_schema')) order by col.table_schema,col.table_name, col.ordinal_position";
 
+const std::string database::__epoch_query = "select schemaname, relname, pg_relation_filenode(relid) || '.' || n_tup_ins || '.' || n_tup_upd || '.' || n_tup_del || '.' || coalesce(extract(epoch from db.stats_reset)::text, '') as epoch from pg_stat_user_tables, pg_stat_database db where db.datname = current_database() and current_setting('track_counts')::boolean and not pg_is_in_recovery()";
 
 const database::column_query_field_name database::column_field_name = {
 		"table_schema",
@@ -41,12 +42,22 @@ const database::column_query_field_name database::column_field_name = {
 };
 
 
-database::database(unsigned _cuncurrend_connection) throw (storage_exception&) : __remote_database(_cuncurrend_connection) {
+database::database(unsigned _cuncurrend_connection) throw (storage_exception&) : __reattach(false), __remote_database(_cuncurrend_connection) {
+	create_storage_directory(std::to_string(getpid()));
+}
+
+database::database(std::string storageName, unsigned _cuncurrend_connection) throw (storage_exception&) : __reattach(true), __remote_database(_cuncurrend_connection) {
+	if (storageName.empty() || storageName.find('/') != std::string::npos)
+		throw storage_exception("Error creating database: '" + storageName + "' is not a valid storage name. Check the 'storageName' paramether.");
+	create_storage_directory(storageName);
+}
+
+void database::create_storage_directory(std::string name) throw () {
 	#if !defined __WINDOWS_VERSION
 		/*	codice per la creazione di cartelle dedite alla memorizzazione di schemi e tabelle che compongono il database per sistema operativo linux/unix-like	*/
 		__storageDirectory = base_path + __tmpStorageDirectory + "/";
 		mkdir(__storageDirectory.c_str(),  S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-		__storageDirectory += std::to_string(getpid()) + "/";
+		__storageDirectory += name + "/";
 		mkdir(__storageDirectory.c_str(),  S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 	#else
 		/*	codice per la creazione di cartelle dedite alla memorizzazione di schemi e tabelle che compongono il database per sistema operativo windows	*/
@@ -126,9 +137,17 @@ sqlType::type_base* database::column_type(std::string udt_name, std::string char
 }
 
 void database::create_structure(table& structure_table, bool key) {
-	std::unique_ptr<std::list<unsigned long>> _all_column_table_tupleID = structure_table.internalID();
-	for (std::list<unsigned long>::const_iterator it = _all_column_table_tupleID->begin(); it != _all_column_table_tupleID->end(); it++) {
-		std::unique_ptr<std::unordered_map<std::string, std::string>> tuple = structure_table.current(*it);
+	std::unique_ptr<storage::cursor> rows = structure_table.rows();
+	std::list<std::string> fields;
+	fields.push_back(column_field_name.table_schema);
+	fields.push_back(column_field_name.table_name);
+	fields.push_back(column_field_name.column_name);
+	fields.push_back(column_field_name.udt_name);
+	fields.push_back(column_field_name.character_maximum_length);
+	fields.push_back(column_field_name.numeric_precision);
+	fields.push_back(column_field_name.numeric_scale);
+	while (rows->next()) {
+		std::unique_ptr<std::unordered_map<std::string, std::string>> tuple = structure_table.current(rows->ID(), fields);
 		std::string schema_name = tuple->find(column_field_name.table_schema)->second;
 		std::string table_name = tuple->find(column_field_name.table_name)->second;
 		std::string column_name = tuple->find(column_field_name.column_name)->second;
@@ -148,22 +167,85 @@ void database::create_structure(table& structure_table, bool key) {
 	}
 }
 
-void database::load_tuple() throw (basic_exception&) {
+void database::load_tuple(bool reuse) throw (basic_exception&) {
+	std::unique_ptr<std::unordered_map<std::string, std::string>> epochs = (__reattach ? remote_epoch() : std::unique_ptr<std::unordered_map<std::string, std::string>>(new std::unordered_map<std::string, std::string>));
 	for (std::unordered_map<std::string, schema>::iterator schema_it = __schemasMap.begin(); schema_it!=__schemasMap.end(); schema_it++) {
 		std::unique_ptr<std::unordered_map<std::string, std::string>> load_commands = schema_it->second.load_command();
 		for (std::unordered_map<std::string, std::string>::const_iterator commands_it = load_commands->begin(); commands_it != load_commands->end(); commands_it++) {
+			table& _table = schema_it->second.get_table(commands_it->first);
+			std::string epoch;
+			std::unordered_map<std::string, std::string>::const_iterator epoch_it = epochs->find(schema_it->first + "." + commands_it->first);
+			if (epoch_it != epochs->end())
+				epoch = epoch_it->second + ";" + commands_it->second;
+			if (reuse && !epoch.empty() && _table.epoch() == epoch)
+				continue;	//la tabella remota non è cambiata dall'ultimo caricamento
 			unsigned long query_id = __remote_database.exec_query(commands_it->second);
 			table& _result = __remote_database.get_result(query_id);
-			table& _table = schema_it->second.get_table(commands_it->first);
 			_table.clear();
-			std::unique_ptr<std::list<unsigned long>> tuple_id = _result.internalID();
-			for (std::list<unsigned long>::const_iterator tuple_it = tuple_id->begin(); tuple_it != tuple_id->end(); tuple_it++)
-				_table.load(*_result.current(*tuple_it));
+			class loader : public storage::visitor {
+			public :
+				loader (table& _table) : __table(_table), __descriptor(0), __rows(0) {}
+				virtual void visit (unsigned long, const record& _record) throw (basic_exception&) {
+					// le tuple vengono caricate a blocchi, colonna per colonna, finchè contengono le stesse colonne; le stringhe vengono riutilizzate da un blocco all'altro
+					if (_record.get_descriptor() != __descriptor) {
+						flush();
+						__descriptor = _record.get_descriptor();
+						__columns.clear();
+						for (std::size_t i = 0; i < _record.fields(); i++)
+							__columns.push_back(_record.name(i));
+						__values.assign(__columns.size(), std::vector<std::string>(record::batch::default_rows));
+					}
+					field value;
+					for (std::size_t i = 0; i < _record.fields(); i++) {
+						_record.current(i, value);
+						__values[i][__rows].assign(value.data(), value.size());
+					}
+					if (++__rows == record::batch::default_rows)
+						flush();
+				}
+				void flush () throw (basic_exception&) {
+					if (__rows == 0)
+						return;
+					if (__rows < record::batch::default_rows)
+						for (std::size_t i = 0; i < __values.size(); i++)
+							__values[i].resize(__rows);
+					__table.load(__columns, __values);
+					__rows = 0;
+				}
+			private :
+				table& __table;
+				const record::descriptor* __descriptor;
+				std::vector<std::string> __columns;
+				std::vector<std::vector<std::string>> __values;
+				std::size_t __rows;
+			} tuple_loader(_table);
+			_table.begin_bulk(_result.numRecords());
+			_result.scan(tuple_loader);
+			tuple_loader.flush();
+			_table.end_bulk();
+			_table.epoch(epoch);
 			__remote_database.erase(query_id);
 		}
 	}
 }
 
+std::unique_ptr<std::unordered_map<std::string, std::string>> database::remote_epoch() throw (basic_exception&) {
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+	unsigned long query_id = __remote_database.exec_query(__epoch_query);
+	table& _result = __remote_database.get_result(query_id);
+	std::unique_ptr<storage::cursor> rows = _result.rows();
+	std::list<std::string> fields;
+	fields.push_back("schemaname");
+	fields.push_back("relname");
+	fields.push_back("epoch");
+	while (rows->next()) {
+		std::unique_ptr<std::unordered_map<std::string, std::string>> tuple = _result.current(rows->ID(), fields);
+		map_ptr->insert(std::pair<std::string, std::string>(tuple->find("schemaname")->second + "." + tuple->find("relname")->second, tuple->find("epoch")->second));
+	}
+	__remote_database.erase(query_id);
+	return map_ptr;
+}
+
 std::unique_ptr<std::list<unsigned long>> database::commit() throw (basic_exception&) {
 	std::unique_ptr<std::list<std::string>> command_list = command_generator();
 	std::unique_ptr<std::list<unsigned long>> id_list(new std::list<unsigned long>);
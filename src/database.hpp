@@ -29,11 +29,18 @@ public:
 		 */
 		explicit database(unsigned _cuncurrend_connection = 5) throw (storage_exception&);
 
+		/* La seconda versione del costruttore memorizza le tabelle nella cartella storageName, anziché in una cartella legata al processo, e riutilizza le righe
+		 * memorizzate in essa da una precedente esecuzione: dopo load_structure le tabelle contengono già le righe salvate alla distruzione del precedente oggetto
+		 * database, e load_tuple(true) ricarica soltanto le tabelle il cui contenuto nel database remoto risulta cambiato nel frattempo.
+		 * Una cartella può essere utilizzata da un solo processo alla volta: se una tabella è già in uso viene generata una eccezione di tipo file_open.
+		 */
+		explicit database(std::string storageName, unsigned _cuncurrend_connection = 5) throw (storage_exception&);
+
 		/* La funzione consente l'aggiunta di uno schema alla struttura del database. Se esiste già uno schema con nome uguale a quello che si sta per inserire, viene
 		 * generata una eccezione di tipo 'schema_exists', derivata da 'access_exception'
 		 */
 		void add_schema(std::string schemaName) throw (schema_exists&)
-			{(find_schema(schemaName) ? throw("Schema '" + schemaName + "' already exists in database.") : __schemasMap.insert(std::pair<std::string, schema>(schemaName, schema(schemaName, __storageDirectory, this))));}
+			{(find_schema(schemaName) ? throw("Schema '" + schemaName + "' already exists in database.") : __schemasMap.insert(std::pair<std::string, schema>(schemaName, schema(schemaName, __storageDirectory, this, __reattach))));}
 
 		/* La funzione restituisce il numero di schemi che compongono il database.
 		 */
@@ -148,9 +155,16 @@ public:
 
 		/* Le due seguenti funzioni consentono, rispettivamente, di generare localmente la struttura del database remoto e di caricare localmente
 		 * le tuple gestite dal database remoto.
+		 * Per default load_tuple ricarica tutte le tabelle. Se il database è stato costruito specificando una cartella (vedi costruttore) e reuse è true,
+		 * vengono ricaricate soltanto le tabelle il cui epoch (vedi table::epoch) non corrisponde più a quello della tabella remota. L'epoch di una tabella
+		 * remota è composto dal comando di caricamento, dai contatori di pg_stat_user_tables (righe inserite, modificate e cancellate, oltre al filenode, che
+		 * cambia a seguito di truncate) e dall'istante dell'ultimo azzeramento delle statistiche (pg_stat_database.stats_reset). Se track_counts è disattivato
+		 * o il server è in standby i contatori non sono affidabili, per cui tutte le tabelle vengono ricaricate anche se reuse è true.
+		 * Attenzione: con reuse true le righe restituite possono non essere aggiornate. I contatori non sono transazionali e le modifiche effettuate da altre
+		 * sessioni vi vengono riportate con un ritardo che può arrivare a qualche secondo: una tabella modificata in questo intervallo non viene ricaricata.
 		 */
 		void load_structure() throw (basic_exception&);
-		void load_tuple() throw (basic_exception&);
+		void load_tuple(bool reuse = false) throw (basic_exception&);
 
 		/* La funzione commit() consente di rendere effettive tutte le modifiche effetuate localmente, eseguendo comandi sql sul database remoto.
 		 * E' bene richiamare la funzione load_tuple al termine delle  operazioni di commit. Restituisce una lista contenente gli id corrispondenti
@@ -168,6 +182,7 @@ private:
 		static const std::string					__tmpStorageDirectory;	/*	percorso base della cartella in cui viene creato l'insieme di file e directory per lo storage delle
 																			 *	tabelle e degli schemi che compongono il database
 																			 */
+		bool										__reattach;				/*	true se le tabelle riutilizzano le righe memorizzate da una precedente esecuzione	*/
 		std::unordered_map<std::string, schema>		__schemasMap;			/*	mappa degli schemi che compongono il database
 																			 *	Gli schemi vengono organizzati in una struttura di tipo 'unordered_map', ossia un contenitore di tipo
 																			 *  associativo che consente di accedere a qualsiasi posizione in tempo costante. Le chiavi di accesso a
@@ -186,9 +201,18 @@ private:
 		std::unordered_map<std::string, schema>::iterator get_iterator(std::string schemaName) throw (schema_not_exists&);
 
 
+		/* La funzione create_storage_directory crea la cartella name all'interno della cartella __tmpStorageDirectory e la imposta come __storageDirectory.
+		 */
+		void create_storage_directory(std::string name) throw ();
+
 		/*parte "remota"*/
 		static const std::string __other_column;
 		static const std::string __key_column;
+		static const std::string __epoch_query;
+
+		/* La funzione remote_epoch restituisce l'epoch delle tabelle remote, indicizzato per "schema.tabella". Vedi load_tuple.
+		 */
+		std::unique_ptr<std::unordered_map<std::string, std::string>> remote_epoch() throw (basic_exception&);
 		struct column_query_field_name {
 			std::string table_schema;
 			std::string table_name;
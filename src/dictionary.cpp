@@ -0,0 +1,39 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "dictionary.hpp"
+using namespace openDB;
+
+const std::string* dictionary::intern (const std::string& column, const std::string& value) throw () {
+	entry& _entry = __columns[column];
+	if (!_entry.stats.enabled)
+		return 0;
+	_entry.stats.samples++;
+	std::unordered_set<std::string>::const_iterator it = _entry.values.find(value);
+	if (it != _entry.values.end()) {
+		_entry.stats.hits++;
+		return &*it;
+	}
+	if (_entry.values.size() >= max_entries || (_entry.stats.samples > probe_size && _entry.values.size() * max_ratio > _entry.stats.samples)) {
+		_entry.stats.enabled = false;
+		return 0;
+	}
+	_entry.stats.entries++;
+	_entry.stats.bytes += value.size();
+	return &*_entry.values.insert(value).first;
+}
+
+std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>> dictionary::stats () const throw () {
+	std::unique_ptr<std::unordered_map<std::string, statistics>> map_ptr(new std::unordered_map<std::string, statistics>);
+	for (std::unordered_map<std::string, entry>::const_iterator it = __columns.begin(); it != __columns.end(); it++)
+		map_ptr->insert(std::pair<std::string, statistics>(it->first, it->second.stats));
+	return map_ptr;
+}
@@ -0,0 +1,76 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OPENDB_DICTIONARY_HEADER__
+#define __OPENDB_DICTIONARY_HEADER__
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace openDB {
+/* La classe dictionary implementa la codifica a dizionario dei valori delle colonne di tipo testuale (varchar e character) di una tabella. Per ciascuna
+ * colonna il dizionario conserva una sola copia di ogni valore distinto, alla quale le celle delle tuple fanno riferimento (vedi cell::share) anziché
+ * memorizzarne una copia propria: una colonna con pochi valori distinti, come un codice di stato o il nome di una città, occupa così la memoria di quei
+ * pochi valori, indipendentemente dal numero di tuple.
+ * La codifica viene scelta automaticamente, colonna per colonna, in base alla cardinalità osservata durante gli inserimenti: dopo i primi probe_size valori,
+ * se i valori distinti superano una frazione 1/max_ratio dei valori inseriti, o in ogni caso se superano max_entries, la codifica della colonna viene
+ * disabilitata. I valori già memorizzati restano validi fino alla chiamata della funzione clear, che può avvenire solo dopo la distruzione delle tuple che
+ * vi fanno riferimento.
+ */
+class dictionary {
+public:
+		/* La struttura statistics descrive lo stato del dizionario di una colonna:
+		 * 	- entries: numero di valori distinti memorizzati;
+		 * 	- bytes: byte occupati dai valori memorizzati;
+		 * 	- samples: numero di valori sottoposti al dizionario;
+		 * 	- hits: numero di valori già presenti nel dizionario;
+		 * 	- enabled: true se la codifica è ancora attiva per la colonna.
+		 */
+		struct statistics {
+				unsigned long	entries;
+				std::size_t		bytes;
+				unsigned long	samples;
+				unsigned long	hits;
+				bool			enabled;
+				statistics() : entries(0), bytes(0), samples(0), hits(0), enabled(true) {}
+		};
+
+		dictionary () throw () {}
+
+		/* La funzione intern restituisce l'indirizzo della copia di value conservata nel dizionario della colonna column, inserendola se non è presente,
+		 * oppure 0 se la codifica della colonna è disabilitata. L'indirizzo resta valido fino alla chiamata della funzione clear.
+		 */
+		const std::string* intern (const std::string& column, const std::string& value) throw ();
+
+		/* La funzione clear svuota il dizionario e riabilita la codifica di tutte le colonne. */
+		void clear () throw ()
+			{__columns.clear();}
+
+		/* La funzione stats restituisce le statistiche del dizionario di ciascuna colonna per la quale è stata richiesta la codifica di almeno un valore. */
+		std::unique_ptr<std::unordered_map<std::string, statistics>> stats () const throw ();
+
+		static const unsigned long probe_size = 1024;
+		static const unsigned long max_ratio = 4;
+		static const unsigned long max_entries = 65536;
+
+private:
+		struct entry {
+				std::unordered_set<std::string>	values;
+				statistics						stats;
+		};
+
+		std::unordered_map<std::string, entry>	__columns;
+};
+}; /*	end of openDB namespace	*/
+#endif
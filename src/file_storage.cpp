@@ -10,14 +10,75 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include "file_storage.hpp"
+#include "common.hpp"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/file.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 using namespace openDB;
 
-file_storage::file_storage(std::string fileName) throw (file_creation&) : storage(), __fileName(fileName), __trashID(0) {
-	std::fstream file;
-	file.open(__fileName.c_str(), std::ios::binary|std::ios::out);
-	if(!file.is_open())
+/* Le funzioni seguenti ripetono la chiamata pread/pwrite finchè non sono stati trasferiti tutti i byte richiesti, gestendo le letture/scritture parziali e le
+ * interruzioni dovute a segnali. Restituiscono false in caso di errore o di fine del file prematura.
+ */
+static bool positional_read (int fd, char* buffer, std::size_t count, off_t offset) {
+	while (count > 0) {
+		ssize_t done = pread(fd, buffer, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		buffer += done;
+		offset += done;
+		count -= done;
+	}
+	return true;
+}
+
+static bool positional_write (int fd, const char* buffer, std::size_t count, off_t offset) {
+	while (count > 0) {
+		ssize_t done = pwrite(fd, buffer, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		buffer += done;
+		offset += done;
+		count -= done;
+	}
+	return true;
+}
+
+file_storage::file_storage(std::string fileName, bool reattach) throw (storage_exception&) : storage(), __fileName(fileName), __fd(-1), __fileEnd(0), __persistent(reattach), __bulk(false),
+	__compactionRatio(default_compaction_ratio), __compactionMinimum(default_compaction_minimum), __updateSlack(default_update_slack) {
+	__fd = open(__fileName.c_str(), (reattach ? O_RDWR|O_CREAT : O_RDWR|O_CREAT|O_TRUNC), S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if(__fd < 0)
 		throw file_creation("Error: '" + __fileName + "' can not be created!");
-	file.close();
+	if (reattach) {
+		if (flock(__fd, LOCK_EX|LOCK_NB) != 0) {
+			close(__fd);
+			__fd = -1;
+			throw file_open("Error: '" + __fileName + "' is in use by another process!");
+		}
+		if (!load_index())
+			clear();
+	}
+}
+
+file_storage::~file_storage() {
+	if (__fd >= 0) {
+		if (__persistent) {
+			try {
+				flush();
+				store_index();
+			}
+			catch (storage_exception&) {}	//i record accumulati non sono stati scritti: l'indice non viene salvato e il file non verrà riutilizzato
+		}
+		close(__fd);
+	}
 }
 
 std::unique_ptr<std::list<unsigned long>> file_storage::internalID () const throw () {
@@ -29,40 +90,124 @@ std::unique_ptr<std::list<unsigned long>> file_storage::internalID () const thro
 
 void file_storage::clear () throw () {
 	__recordMap.clear();
+	__cache.clear();
 	__trash.clear();
+	__bulkBuffer.clear();
+	__pending.clear();
+	if (ftruncate(__fd, 0) == 0)
+		__fileEnd = 0;
 	__lastKey = 0;
-	__trashID = 0;
+	__epoch.clear();
 }
 
 unsigned long file_storage::insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) {
+	if (__bulk) {
+		std::size_t size = __bulkBuffer.size();
+		record::write(__bulkBuffer, valuesMap, columnsMap, _state);
+		return bulk_append(__bulkBuffer.size() - size, _state);
+	}
 	record _record(valuesMap, columnsMap, _state);
-	unsigned long free_space = recycle(_record.size());
-	if (free_space == 0)
-		append(_record, __recordMap[__lastKey]);
-	else {
-		__recordMap[__lastKey + 1] = popTrash(free_space, _record.size());
-		write(_record, __recordMap[__lastKey]);
+	return place(_record);
+}
+
+unsigned long file_storage::insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) {
+	unsigned long first = __lastKey;
+	for (std::size_t row = 0; row < _batch.rows(); row++)
+		if (__bulk) {
+			std::size_t size = __bulkBuffer.size();
+			record::write(__bulkBuffer, _batch, row, _state);
+			bulk_append(__bulkBuffer.size() - size, _state);
+		}
+		else {
+			record _record(_batch, row, _state);
+			place(_record);
+		}
+	return first;
+}
+
+unsigned long file_storage::bulk_append (std::size_t byte, enum record::state _state) throw (storage_exception&) {
+	segment _segment;
+	_segment.begin = __fileEnd;
+	_segment.end = __fileEnd + (std::streamoff) byte - (std::streamoff)1;
+	_segment.state = _state;
+	_segment.visible = (_state != record::deleting);
+	__fileEnd += byte;
+	__recordMap.insert(std::pair<unsigned long, segment>(__lastKey, _segment));
+	track(__lastKey, _state);
+	if (__bulkBuffer.size() >= bulk_buffer)
+		flush();
+	return __lastKey++;
+}
+
+unsigned long file_storage::place (record& _record) throw (storage_exception&) {
+	segment _segment;
+	if (recycle(_record.size(), _segment))
+		write(_record, _segment);
+	else
+		append(_record, _segment);
+	_segment.mark(_record);
+	__recordMap[__lastKey] = _segment;
+	track(__lastKey, _segment.state);
+	__cache.insert(__lastKey, std::move(_record));
+	return __lastKey++;
+}
+
+unsigned long file_storage::store (const record& _record) throw (storage_exception&) {
+	segment _segment;
+	if (__bulk) {
+		std::size_t size = __bulkBuffer.size();
+		_record.write(__bulkBuffer);
+		_segment.begin = __fileEnd;
+		_segment.end = __fileEnd + (std::streamoff) (__bulkBuffer.size() - size) - (std::streamoff)1;
+		__fileEnd += __bulkBuffer.size() - size;
 	}
+	else if (recycle(_record.size(), _segment))
+		write(_record, _segment);
+	else
+		append(_record, _segment);
+	_segment.mark(_record);
+	__recordMap[__lastKey] = _segment;
+	track(__lastKey, _segment.state);
+	if (__bulk && __bulkBuffer.size() >= bulk_buffer)
+		flush();
 	return __lastKey++;
 }
 
 void file_storage::update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) {
 	std::unique_ptr<record> record_ptr = get_record(ID);
 	record_ptr -> update(valuesMap, columnsMap);
-	pushTrash(__recordMap[ID]);
-	unsigned long free_space = recycle(record_ptr -> size());
-	if (free_space == 0)
-		append(*record_ptr, __recordMap[ID]);
-	else {
-		__recordMap[ID] = popTrash(free_space, record_ptr->size());
-		write(*record_ptr, __recordMap[ID]);
-	}
+	rewrite(ID, *record_ptr);
 }
 
 void file_storage::cancel (unsigned long ID) throw (storage_exception&) {
 	std::unique_ptr<record> tuple_ptr = get_record(ID);
 	tuple_ptr -> cancel();
-	write(*tuple_ptr, __recordMap[ID]);
+	rewrite(ID, *tuple_ptr);
+}
+
+void file_storage::rewrite (unsigned long ID, record& _record) throw (storage_exception&) {
+	segment _segment = get_segment(ID);
+	std::streamoff size = _record.size();
+	bool relocated = (size > _segment.size() + _segment.slack);
+	if (!relocated) {		//il record entra nello spazio che occupa già: viene riscritto sul posto
+		_segment.slack += _segment.size() - size;
+		_segment.end = _segment.begin + size - (std::streamoff)1;
+		write(_record, _segment);
+	}
+	else {
+		_segment.slack = (std::streamoff) (size * __updateSlack);
+		if (recycle(size, _segment))
+			write(_record, _segment);
+		else
+			append(_record, _segment);
+		pushTrash(get_segment(ID));
+	}
+	_segment.mark(_record);
+	__recordMap[ID] = _segment;
+	track(ID, _segment.state);
+	__cache.insert(ID, std::move(_record));
+	if (relocated)
+		autocompact();
 }
 
 void file_storage::erase (unsigned long ID) throw (storage_exception&) {
@@ -70,101 +215,392 @@ void file_storage::erase (unsigned long ID) throw (storage_exception&) {
 	if (record_it != __recordMap.end()) {
 		pushTrash(record_it ->second);
 		__recordMap.erase(record_it);
+		__cache.erase(ID);
+		untrack(ID);
+		autocompact();
 	}
 	else
 		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
 }
 
+std::unique_ptr<std::unordered_map<std::string, std::string>> file_storage::current(unsigned long ID) const throw (storage_exception&) {
+	const record* cached = __cache.find(ID);
+	if (cached)
+		return cached->current();
+	std::unique_ptr<record> record_ptr = get_record(ID);
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr = record_ptr->current();
+	__cache.insert(ID, std::move(*record_ptr));
+	return map_ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> file_storage::old(unsigned long ID) const throw (storage_exception&) {
+	const record* cached = __cache.find(ID);
+	if (cached)
+		return cached->old();
+	std::unique_ptr<record> record_ptr = get_record(ID);
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr = record_ptr->old();
+	__cache.insert(ID, std::move(*record_ptr));
+	return map_ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> file_storage::current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&) {
+	const segment& _segment = get_segment(ID);
+	const record* cached = __cache.find(ID);
+	if (cached)
+		return cached->current(columns);
+	std::string buffer;
+	return record::project(window(_segment.begin, _segment.end, buffer), _segment.size(), columns);
+}
+
+void file_storage::visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&) {
+	const record* cached = __cache.find(ID);
+	if (cached) {
+		_visitor.visit(ID, *cached);
+		return;
+	}
+	std::unique_ptr<record> record_ptr = get_record(ID);
+	_visitor.visit(ID, *record_ptr);
+	__cache.insert(ID, std::move(*record_ptr));
+}
+
 std::unique_ptr<record>	file_storage::get_record (unsigned long ID) const throw (storage_exception&) {
+	const segment& _segment = get_segment(ID);
+	const record* cached = __cache.find(ID);
+	if (cached)
+		return std::unique_ptr<record>(new record(*cached));
+	std::unique_ptr<record> ptr(new record);
+	read(*ptr, _segment);
+	return ptr;
+}
+
+const file_storage::segment& file_storage::get_segment (unsigned long ID) const throw (storage_exception&) {
 	std::unordered_map<unsigned long, segment>::const_iterator record_it = __recordMap.find(ID);
-	if (record_it != __recordMap.end()) {
-		std::unique_ptr<record> ptr(new record);
-		read(*ptr, record_it->second);
-		return ptr;
-	}
+	if (record_it != __recordMap.end())
+		return record_it->second;
 	else
 		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
 }
 
 void file_storage::write (const record& _record, const segment _segment) const throw (storage_exception&) {
-	std::fstream file;
-	file.open(__fileName.c_str(), std::ios::binary|std::ios::in|std::ios::out);
-	if(!file.is_open())
-		throw file_open("Error: '" + __fileName + "' can not be opened!");
-	file.seekp(_segment.begin);
-	_record.write(file);
-	if (file.tellg() != _segment.end + (std::streampos)1)
+	flush();
+	std::string buffer;
+	_record.write(buffer);
+	if ((std::streamoff) buffer.size() != _segment.size())
+		throw io_error("I/O error during write: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	if (!positional_write(__fd, buffer.data(), buffer.size(), (std::streamoff) _segment.begin))
 		throw io_error("I/O error during write: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
-	file.close();
 }
 
 void file_storage::append (const record& _record, segment& _segment) throw (storage_exception&) {
-	std::fstream file;
-	file.open(__fileName.c_str(), std::ios::binary|std::ios::in|std::ios::out|std::ios::ate);
-	if(!file.is_open())
-		throw file_open("Error: '" + __fileName + "' can not be opened!");
-	_segment.begin = file.tellp();
-	_record.write(file);
-	_segment.end = file.tellp() - (std::streamoff)1;
+	flush();
+	std::string buffer;
+	_record.write(buffer);
+	if (!positional_write(__fd, buffer.data(), buffer.size(), __fileEnd))
+		throw io_error("I/O error during append: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	_segment.begin = __fileEnd;
+	_segment.end = __fileEnd + (std::streamoff) buffer.size() - (std::streamoff)1;
+	__fileEnd += buffer.size() + _segment.slack;
 	if (_record.size() != _segment.size())
 		throw io_error("I/O error during append: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
-	file.close();
 }
 
 void file_storage::read (record& _record, const segment _segment) const throw (storage_exception&) {
-	std::fstream file;
-	file.open(__fileName.c_str(), std::ios::binary|std::ios::in|std::ios::out);
-	if(!file.is_open())
-		throw file_open("Error: '" + __fileName + "' can not be opened!");
-	file.seekg(_segment.begin);
-	_record.read(file);
-	if ((_record.size() != _segment.size()) | (file.tellg() != _segment.end + (std::streamoff)1))
+	flush();
+	std::string buffer(_segment.size(), '\0');
+	if (!positional_read(__fd, &buffer[0], buffer.size(), (std::streamoff) _segment.begin))
 		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
-	file.close();
-}
-
-void file_storage::pushTrash (segment _segment) {
-	bool neighbor = false;
-	std::unordered_map <unsigned long, segment>::iterator it = __trash.begin();
-	if (!__trash.empty())
-		while (it != __trash.end() && !neighbor) {	//se il segmento che si aggiunge al cestino è adiacente ad uno già esistente, allora il segmento nel cestino viene
-													//opportunamente esteso
-			if (it->second.end + (std::streamoff)1 == _segment.begin) {
-				it->second.end = _segment.end;
-				neighbor = true;
-			}
-			if (it->second.begin - (std::streamoff)1 == _segment.end) {
-				it->second.begin = _segment.begin;
-				neighbor = true;
-			}
-			it++;
+	_record.read(buffer.data(), buffer.size());
+}
+
+std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> file_storage::fetch (const std::list<unsigned long>& IDs) const throw (storage_exception&) {
+	std::vector<const record*> cached;
+	std::vector<segment> segments;
+	cached.reserve(IDs.size());
+	for (std::list<unsigned long>::const_iterator it = IDs.begin(); it != IDs.end(); it++) {
+		const segment& _segment = get_segment(*it);
+		cached.push_back(__cache.find(*it));
+		if (!cached.back())
+			segments.push_back(_segment);
+	}
+	std::vector<record> records(segments.size());
+	read(records, segments);
+	std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> list_ptr(new std::list<std::unordered_map<std::string, std::string>>);
+	std::vector<record>::const_iterator record_it = records.begin();
+	for (std::vector<const record*>::const_iterator it = cached.begin(); it != cached.end(); it++)
+		list_ptr->push_back(std::move(*(*it ? (*it)->current() : (record_it++)->current())));
+	return list_ptr;
+}
+
+void file_storage::read (std::vector<record>& records, const std::vector<segment>& segments) const throw (storage_exception&) {
+	flush();
+	std::vector<std::string> buffers(segments.size());
+	std::vector<io_ring::request> requests(segments.size());
+	for (std::size_t i = 0; i < segments.size(); i++) {
+		buffers[i].resize(segments[i].size());
+		requests[i].buffer = &buffers[i][0];
+		requests[i].count = buffers[i].size();
+		requests[i].offset = segments[i].begin;
+		requests[i].result = -1;
+	}
+	if (segments.size() > 1) {
+		if (!__ring)
+			__ring.reset(new io_ring);
+		if (!__ring->read(__fd, requests))
+			for (std::size_t i = 0; i < requests.size(); i++)
+				requests[i].result = -1;
+	}
+	for (std::size_t i = 0; i < segments.size(); i++) {
+		std::size_t done = (requests[i].result > 0 ? requests[i].result : 0);		//le letture non eseguite o incomplete vengono completate in modo sincrono
+		if (done < requests[i].count && !positional_read(__fd, requests[i].buffer + done, requests[i].count - done, requests[i].offset + done))
+			throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+		records[i].read(buffers[i].data(), buffers[i].size());
+	}
+}
+
+void file_storage::scan (visitor& _visitor) const throw (basic_exception&) {
+	typedef std::pair<std::streamoff, const std::pair<const unsigned long, segment>*> position;
+	std::vector<position> order;
+	order.reserve(__recordMap.size());
+	for (std::unordered_map<unsigned long, segment>::const_iterator it = __recordMap.begin(); it != __recordMap.end(); it++)
+		order.push_back(position(it->second.begin, &*it));
+	std::sort(order.begin(), order.end());
+
+	std::string buffer;
+	record _record;
+	std::vector<position>::const_iterator first = order.begin();
+	while (first != order.end()) {
+		std::streamoff begin = first->first;
+		std::streamoff end = first->second->second.end;
+		std::vector<position>::const_iterator last = first + 1;
+		for (; last != order.end() && (std::streamoff) last->second->second.end - begin < (std::streamoff) scan_window; last++)
+			end = last->second->second.end;
+		const char* data = window(begin, end, buffer);
+		for (; first != last; first++) {
+			const segment& _segment = first->second->second;
+			_record.read(data + (first->first - begin), _segment.size());
+			_visitor.visit(first->second->first, _record);
 		}
-	if (!neighbor) {							//altrimenti viene aggiunto un nuovo segmento nel cestino
-		__trash.insert(std::pair<unsigned long,segment>(__trashID + 1, _segment));
-		++__trashID;
 	}
 }
 
-unsigned long file_storage::recycle (std::streamoff byte) const {
-	unsigned long index = 0;
-	if (!__trash.empty()) {
-		std::unordered_map <unsigned long, segment>::const_iterator it = __trash.begin();
-		while (index == 0 && it != __trash.end())
-			if (it -> second.size() >= byte)
-				index = it -> first;
-			else
-				it++;
+const char* file_storage::window (std::streamoff begin, std::streamoff end, std::string& buffer) const throw (storage_exception&) {
+	flush();
+	buffer.resize(end - begin + 1);
+	if (!positional_read(__fd, &buffer[0], buffer.size(), begin))
+		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	return buffer.data();
+}
+
+bool file_storage::recycle (std::streamoff byte, segment& _segment) throw () {
+	std::streamoff begin;
+	if (!__trash.pop(byte + _segment.slack, begin))
+		return false;
+	_segment.begin = begin;
+	_segment.end = begin + byte - (std::streamoff)1;
+	return true;
+}
+
+void file_storage::compact () throw (storage_exception&) {
+	flush();
+	std::vector<std::pair<std::streamoff, segment*>> order;
+	sorted(order);
+
+	std::streamoff destination = 0;
+	std::vector<std::pair<std::streamoff, segment*>>::iterator first = order.begin();
+	while (first != order.end()) {
+		std::streamoff begin = first->second->begin, end = first->second->end;
+		std::vector<std::pair<std::streamoff, segment*>>::iterator last = first + 1;
+		while (last != order.end() && (std::streamoff) last->second->begin == end + 1)		//i record adiacenti vengono spostati insieme
+			end = (last++)->second->end;
+		if (begin != destination)
+			move(begin, destination, end - begin + 1);
+		for (; first != last; first++) {		//lo spazio riservato ai record viene rilasciato
+			first->second->begin -= begin - destination;
+			first->second->end -= begin - destination;
+			first->second->slack = 0;
+		}
+		destination += end - begin + 1;
+	}
+	__fileEnd = destination;
+	__trash.clear();
+	truncate();
+}
+
+void file_storage::move (std::streamoff from, std::streamoff to, std::streamoff byte) throw (storage_exception&) {
+	std::string buffer(std::min<std::streamoff>(byte, 1048576), '\0');
+	while (byte > 0) {		//to < from: ogni blocco viene letto prima che la scrittura dei blocchi successivi possa sovrascriverlo
+		std::size_t count = std::min<std::streamoff>(byte, buffer.size());
+		if (!positional_read(__fd, &buffer[0], count, from) || !positional_write(__fd, buffer.data(), count, to))
+			throw io_error("I/O error during compaction: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+		from += count;
+		to += count;
+		byte -= count;
 	}
-	return index;
 }
 
-file_storage::segment file_storage::popTrash (unsigned long id, std::streamoff byte) {
-	std::unordered_map<unsigned long, segment>::iterator it = __trash.find(id);
-	segment _segment;
-	_segment.begin = it->second.begin;
-	_segment.end = _segment.begin + byte - (std::streamoff)1;
-	it->second.begin = _segment.end + (std::streamoff)1;
-	if (it->second.size() == 0)
-		__trash.erase(it);
-	return _segment;
+void file_storage::truncate () throw (storage_exception&) {
+	if (ftruncate(__fd, __fileEnd) != 0)
+		throw io_error("I/O error: '" + __fileName + "' can not be truncated!");
+}
+
+void file_storage::autocompact () throw (storage_exception&) {
+	if (__compactionRatio > 0 && __fileEnd >= __compactionMinimum && __trash.bytes() >= __compactionRatio * __fileEnd)
+		compact();
+}
+
+void file_storage::begin_bulk (unsigned long records) throw () {
+	__bulk = true;
+	reserve(records);
+}
+
+void file_storage::end_bulk () throw (storage_exception&) {
+	__bulk = false;
+	flush();
+	std::string().swap(__bulkBuffer);
+}
+
+void file_storage::flush () const throw (storage_exception&) {
+	if (__bulkBuffer.empty())
+		return;
+	if (!positional_write(__fd, __bulkBuffer.data(), __bulkBuffer.size(), __fileEnd - (std::streamoff) __bulkBuffer.size()))
+		throw io_error("I/O error during append: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	__bulkBuffer.clear();
+}
+
+void file_storage::sorted (std::vector<std::pair<std::streamoff, segment*>>& order) throw () {
+	order.clear();
+	order.reserve(__recordMap.size());
+	for (std::unordered_map<unsigned long, segment>::iterator it = __recordMap.begin(); it != __recordMap.end(); it++)
+		order.push_back(std::pair<std::streamoff, segment*>(it->second.begin, &it->second));
+	std::sort(order.begin(), order.end());
+}
+
+/* L'indice viene scritto in coda al file, dopo l'ultimo record, nel formato seguente:
+ * 	- __lastKey, numero di record e, per ciascun record, chiave, begin, end, spazio riservato, stato e visibilità (la versione 1 del formato non contiene lo
+ * 	  spazio riservato);
+ * 	- epoch;
+ * seguito dalla coda, di dimensione fissa: dimensione dell'indice, checksum dell'indice (FNV-1a), versione del formato e identificativo index_magic.
+ * I valori sono memorizzati nella rappresentazione della macchina, esattamente come nei record: un file non è trasportabile tra architetture diverse.
+ */
+static const char index_magic[8] = {'o', 'D', 'B', 'i', 'n', 'd', 'e', 'x'};
+static const unsigned index_version = 2;
+static const std::streamoff index_tail = sizeof(std::streamoff) + sizeof(unsigned long long) + sizeof(unsigned) + sizeof(index_magic);
+
+template <typename T> static void put (std::string& buffer, const T& value) {
+	buffer.append(reinterpret_cast<const char*> (&value), sizeof(T));
+}
+
+template <typename T> static bool get (const char*& buffer, const char* end, T& value) {
+	if (end - buffer < (std::ptrdiff_t) sizeof(T))
+		return false;
+	std::memcpy(&value, buffer, sizeof(T));
+	buffer += sizeof(T);
+	return true;
+}
+
+static unsigned long long checksum (const char* buffer, std::size_t size) {
+	unsigned long long hash = 14695981039346656037ULL;
+	for (std::size_t i = 0; i < size; i++) {
+		hash ^= (unsigned char) buffer[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool file_storage::load_index () throw () {
+	off_t fileSize = lseek(__fd, 0, SEEK_END);
+	if (fileSize < index_tail)
+		return false;
+	std::string tail(index_tail, '\0');
+	if (!positional_read(__fd, &tail[0], tail.size(), fileSize - index_tail))
+		return false;
+	const char* tail_it = tail.data();
+	const char* tail_end = tail.data() + tail.size();
+	std::streamoff indexSize;
+	unsigned long long indexChecksum;
+	unsigned version;
+	get(tail_it, tail_end, indexSize);
+	get(tail_it, tail_end, indexChecksum);
+	get(tail_it, tail_end, version);
+	if (std::memcmp(tail_it, index_magic, sizeof(index_magic)) != 0 || version < 1 || version > index_version || indexSize < 0 || indexSize > fileSize - index_tail)
+		return false;
+
+	std::streamoff dataEnd = fileSize - index_tail - indexSize;
+	std::string index(indexSize, '\0');
+	if (!positional_read(__fd, &index[0], index.size(), dataEnd) || checksum(index.data(), index.size()) != indexChecksum)
+		return false;
+	const char* it = index.data();
+	const char* index_end = index.data() + index.size();
+	unsigned long lastKey, records;
+	if (!get(it, index_end, lastKey) || !get(it, index_end, records))
+		return false;
+	std::unordered_map<unsigned long, segment> recordMap;
+	recordMap.reserve(records);
+	for (unsigned long i = 0; i < records; i++) {
+		unsigned long ID;
+		std::streamoff _begin, _end;
+		segment _segment;
+		if (!get(it, index_end, ID) || !get(it, index_end, _begin) || !get(it, index_end, _end) || (version > 1 && !get(it, index_end, _segment.slack)) || !get(it, index_end, _segment.state) || !get(it, index_end, _segment.visible))
+			return false;
+		if (_begin < 0 || _end < _begin || _segment.slack < 0 || _segment.slack >= dataEnd - _end || ID >= lastKey)
+			return false;
+		_segment.begin = _begin;
+		_segment.end = _end;
+		recordMap.insert(std::pair<unsigned long, segment>(ID, _segment));
+	}
+	std::string epoch;
+	if (!openDB::read(it, index_end, epoch) || it != index_end)
+		return false;
+
+	__recordMap.swap(recordMap);
+	__trash.clear();
+	std::vector<std::pair<std::streamoff, segment*>> order;
+	sorted(order);
+	std::streamoff cursor = 0;
+	for (std::vector<std::pair<std::streamoff, segment*>>::const_iterator order_it = order.begin(); order_it != order.end(); order_it++) {
+		if (order_it->first < cursor) {		//segmenti sovrapposti: l'indice non è valido
+			__recordMap.clear();
+			__trash.clear();
+			return false;
+		}
+		if (order_it->first > cursor)
+			__trash.push(cursor, order_it->first - 1);
+		cursor = order_it->second->end + order_it->second->slack + (std::streamoff)1;
+	}
+	if (cursor < dataEnd)
+		__trash.push(cursor, dataEnd - 1);
+	__fileEnd = dataEnd;
+	__lastKey = lastKey;
+	__epoch = epoch;
+	if (ftruncate(__fd, __fileEnd) != 0) {
+		__recordMap.clear();
+		__trash.clear();
+		return false;
+	}
+	__pending.clear();
+	for (std::unordered_map<unsigned long, segment>::const_iterator record_it = __recordMap.begin(); record_it != __recordMap.end(); record_it++)
+		track(record_it->first, record_it->second.state);
+	return true;
+}
+
+void file_storage::store_index () const throw () {
+	std::string index;
+	put(index, __lastKey);
+	put(index, (unsigned long) __recordMap.size());
+	for (std::unordered_map<unsigned long, segment>::const_iterator it = __recordMap.begin(); it != __recordMap.end(); it++) {
+		put(index, it->first);
+		put(index, (std::streamoff) it->second.begin);
+		put(index, (std::streamoff) it->second.end);
+		put(index, it->second.slack);
+		put(index, it->second.state);
+		put(index, it->second.visible);
+	}
+	openDB::write(index, __epoch);
+	std::streamoff indexSize = index.size();
+	put(index, indexSize);
+	put(index, checksum(index.data(), indexSize));
+	put(index, index_version);
+	index.append(index_magic, sizeof(index_magic));
+	if (!positional_write(__fd, index.data(), index.size(), __fileEnd) || ftruncate(__fd, __fileEnd + index.size()) != 0)
+		if (ftruncate(__fd, __fileEnd) != 0) {}		//l'indice non è stato scritto: il file non verrà riutilizzato
 }
@@ -14,15 +14,34 @@
 #define __OPENDB_FILE_STORAGE_HEADER__
 
 #include "storage.hpp"
+#include "trash.hpp"
+#include "io_ring.hpp"
+#include "record_cache.hpp"
+#include <vector>
 
 namespace openDB{
 /*
  */
 class file_storage : public storage {
 public:
-		/*
+		/* Il costruttore crea il file fileName, troncandolo se esiste già, e lo mantiene aperto per tutta la vita dell'oggetto: tutte le operazioni di lettura e
+		 * scrittura dei record vengono effettuate in modo posizionale, agli offset indicati dai segmenti, sullo stesso descrittore.
+		 * Se non è possibile creare il file viene generata una eccezione di tipo file_creation, derivata da storage_exception.
+		 * Il distruttore chiude il file.
+		 *
+		 * Se il parametro reattach è true il file non viene troncato: se contiene un indice valido, scritto in coda al file dal distruttore di un precedente
+		 * oggetto file_storage, i record che contiene tornano ad essere gestiti, con le stesse chiavi e lo stesso epoch (vedi storage::epoch), senza dover essere
+		 * ricaricati. Se l'indice non esiste o non è valido il file viene troncato, come se reattach fosse false.
+		 * L'indice viene rimosso dal file subito dopo essere stato letto e viene riscritto solo alla distruzione dell'oggetto, per cui un file lasciato da un
+		 * processo terminato in modo anomalo non viene mai riutilizzato.
+		 * Il file viene inoltre bloccato (flock) per tutta la vita dell'oggetto: se è già in uso da parte di un altro processo viene generata una eccezione di
+		 * tipo file_open.
 		 */
-		file_storage(std::string fileName) throw (file_creation&);
+		file_storage(std::string fileName, bool reattach = false) throw (storage_exception&);
+		virtual ~file_storage();
+
+		file_storage(const file_storage&) = delete;
+		file_storage& operator= (const file_storage&) = delete;
 
 		/* La funzione membro 'internalID' restituisce un oggetto std::list di unsigned long, più precisamente un oggetto unique_ptr contenente un puntatore ad un oggetto
 		 * std::list<unsigned long>, che contiene l'elenco delle chiavi generate che sono ancora valide.
@@ -40,6 +59,24 @@ public:
 		 */
 		virtual void clear () throw ();
 
+		/* Le funzioni begin_bulk ed end_bulk delimitano un caricamento massivo. Finchè il caricamento è attivo, insert non cerca spazio libero nel cestino e non
+		 * costruisce oggetti record: i record vengono serializzati direttamente in un buffer in memoria (vedi record::write), scritto sul file con una sola
+		 * operazione ogni bulk_buffer byte e alla chiamata di end_bulk.
+		 * Qualsiasi altra operazione che debba leggere o modificare il file scrive preventivamente il buffer, per cui i record inseriti sono subito accessibili.
+		 * Il parametro records, se noto, è il numero di record che verranno inseriti, e viene usato per dimensionare l'indice.
+		 */
+		virtual void begin_bulk (unsigned long records = 0) throw ();
+		virtual void end_bulk () throw (storage_exception&);
+
+		static const std::size_t bulk_buffer = 4194304;
+
+		/* Le funzioni epoch restituiscono ed impostano la stringa che identifica la versione dei record gestiti. Vedi storage.hpp.
+		 */
+		virtual std::string epoch () const throw ()
+				{return __epoch;}
+		virtual void epoch (std::string _epoch) throw ()
+				{__epoch = _epoch;}
+
 		/* La funzione insert consente di creare un nuovo record e di inserirlo tra quelli gestiti dal gestore.
 		 * I paramentri sono:
 		 * 	- valueMap : mappa il cui primo campo è il nome della colonna in cui inserire il valore contenuto nel secondo campo. Se non esiste nessuna colonna con il nome
@@ -66,6 +103,11 @@ public:
 		 */
 		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&);
 
+		/* La seconda versione della funzione insert inserisce tutte le tuple di un batch (vedi storage.hpp e record::batch). Durante un caricamento massivo le
+		 * tuple vengono serializzate direttamente nel buffer, senza costruire gli oggetti record.
+		 */
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&);
+
 		/* La funzione update consente di marcare i valori di un record affinchè siano aggiornati correttamente dal database remoto. Prende i seguenti parametri:
 		 * consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
 		 * 	- valueMap : mappa il cui primo campo è il nome della colonna in cui inserire il valore contenuto nel secondo campo. Se non esiste nessuna colonna con il nome
@@ -114,7 +156,7 @@ public:
 		 *  - io_error : eccezione derivata da storage_exception, viene generata se la dimensione dei dati scritti-letti non coincide con la dimensione del record.
 		 */
 		virtual enum record::state state (unsigned long ID) const throw (storage_exception&)
-				{return get_record(ID)->state();}
+				{return get_segment(ID).state;}
 
 		/* La funzione visible restituisce true se i valori del record sono 'visibili' ossia se ha senso che siano visibili in una interfaccia. Potrebbe essere privo di
 		 * senso visualizzare i valori di un record che sta per essere cancellato...
@@ -125,7 +167,7 @@ public:
 		 *  - io_error : eccezione derivata da storage_exception, viene generata se la dimensione dei dati scritti-letti non coincide con la dimensione del record.
 		 */
 		virtual bool visible (unsigned long ID)	const throw (storage_exception&)
-				{return get_record(ID)->visible();}
+				{return get_segment(ID).visible;}
 
 		/* La funzione current restituisce un oggetto unordered_map il cui primo campo contiene il nome di una colonna mentre il secondo campo contiene il corrispettivo
 		 * valore memorizzato dalla tupla.
@@ -138,51 +180,213 @@ public:
 		 *  - io_error : eccezione derivata da storage_exception, viene generata se la dimensione dei dati scritti-letti non coincide con la dimensione del record.
 		 * La funzione può generare una eccezione di tipo 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con la chiave contenuta nel
 		 * parametro ID specifico
+		 * Il record viene cercato prima nella cache dei record (vedi cache_size); se non è presente viene letto dal file ed inserito nella cache.
 		 */
-		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&)
-				{return get_record(ID)->current();}
-		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&)
-				{return get_record(ID)->old();}
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&);
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&);
 
-private:
-		/*
+		/* La seconda versione della funzione current restituisce i valori correnti delle colonne columns. Se il record non è presente nella cache, viene letto
+		 * dal file ma non ricostruito: vengono decodificati soltanto i valori richiesti (vedi record::project) ed il record non viene inserito nella cache.
 		 */
-		std::string	__fileName;
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&);
 
-		/*
+		/* La funzione fetch restituisce i valori correnti di più record. Le letture vengono accodate tutte insieme ad un anello io_uring (vedi io_ring.hpp), creato
+		 * alla prima chiamata, in modo che il dispositivo possa servirle in parallelo; se io_uring non è disponibile, i record vengono letti in modo sincrono,
+		 * uno alla volta. Vedi storage.hpp.
+		 * I record presenti nella cache non vengono letti; quelli letti non vengono inseriti nella cache, in modo che la lettura di molti record, come quella
+		 * effettuata da table::to_html, non rimuova dalla cache i record usati più spesso.
+		 */
+		virtual std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> fetch (const std::list<unsigned long>& IDs) const throw (storage_exception&);
+
+		/* La funzione scan visita i record in ordine di offset crescente, anziché nell'ordine dell'indice: i record vengono letti a blocchi di record adiacenti
+		 * di al più scan_window byte, con una singola lettura per blocco, per cui il file viene letto sequenzialmente, una sola volta. I record letti non vengono
+		 * inseriti nella cache. Vedi storage.hpp.
+		 */
+		virtual void scan (visitor& _visitor) const throw (basic_exception&);
+
+		/* La funzione visit legge il record dalla cache o, se non è presente, dal file, inserendolo poi nella cache. Vedi storage.hpp.
+		 */
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&);
+		virtual std::unique_ptr<cursor> rows () const throw ()
+				{return std::unique_ptr<cursor>(new key_cursor<std::unordered_map<unsigned long, segment>::const_iterator>(*this, __recordMap.begin(), __recordMap.end()));}
+
+		static const std::size_t scan_window = 4194304;		/*	4 MiB	*/
+
+		/* Le funzioni store e retrieve consentono di usare l'oggetto come deposito di record già costruiti (vedi hybrid_storage.hpp): store memorizza _record
+		 * così com'è, compresi stato e valori precedenti, con una nuova chiave che viene restituita; retrieve restituisce una copia del record con chiave ID.
+		 * Nessuna delle due funzioni inserisce il record nella cache. Possono generare le stesse eccezioni di insert e current.
+		 */
+		unsigned long store (const record& _record) throw (storage_exception&);
+		std::unique_ptr<record> retrieve (unsigned long ID) const throw (storage_exception&)
+				{return get_record(ID);}
+
+		/* I record letti dal file vengono mantenuti, già deserializzati, in una cache (vedi record_cache.hpp) che contiene al più records record, per default
+		 * record_cache::default_capacity. La cache viene aggiornata da insert, update e cancel, che vi inseriscono il record scritto, e da erase, che lo rimuove.
+		 * Un valore nullo disabilita la cache. La funzione cache_statistics restituisce i contatori della cache.
+		 */
+		void cache_size (std::size_t records) throw ()
+				{__cache.capacity(records);}
+		record_cache::statistics cache_statistics () const throw ()
+				{return __cache.stats();}
+
+		/* La funzione trash_statistics restituisce i contatori relativi allo spazio libero all'interno del file, tra cui il grado di frammentazione. Vedi header
+		 * trash.hpp.
+		 */
+		trash::statistics trash_statistics () const throw ()
+				{return __trash.stats();}
+
+		/* La funzione compact riscrive i record in modo contiguo a partire dall'inizio del file, eliminando lo spazio libero lasciato da update ed erase, aggiorna la
+		 * posizione dei record nell'indice e tronca il file alla dimensione effettivamente occupata. Le chiavi dei record non cambiano.
+		 * I record vengono spostati a blocchi di record adiacenti, dal primo all'ultimo: dopo ogni spostamento l'indice è coerente con il contenuto del file,
+		 * per cui è possibile leggere i record anche se la compattazione viene interrotta da una eccezione.
+		 * Viene generata una eccezione di tipo io_error se non è possibile spostare i record o troncare il file.
+		 */
+		void compact () throw (storage_exception&);
+
+		/* La funzione compaction_policy stabilisce quando la compattazione debba essere avviata automaticamente: al termine di update ed erase, se il file occupa
+		 * almeno minimum byte e la frazione di file occupata da spazio libero è almeno pari a ratio, viene chiamata compact. Un valore di ratio pari a zero (o
+		 * negativo) disabilita la compattazione automatica.
+		 * Per default la compattazione viene avviata quando lo spazio libero raggiunge metà di un file di almeno 1 MiB: in questo modo il costo della
+		 * compattazione, proporzionale ai byte dei record ancora validi, viene ripagato dallo spazio liberato.
+		 */
+		void compaction_policy (double ratio, std::streamoff minimum = default_compaction_minimum) throw ()
+				{__compactionRatio = ratio; __compactionMinimum = minimum;}
+
+		static constexpr double default_compaction_ratio = 0.5;
+		static const std::streamoff default_compaction_minimum = 1048576;
+
+		/* La funzione update_slack stabilisce quanto spazio riservare ad un record quando update deve spostarlo perchè è cresciuto: oltre ai byte del record vengono
+		 * riservati ratio volte i byte del record, in modo che successive modifiche che lo fanno crescere di poco possano essere scritte sul posto. Un record
+		 * modificato che entra nello spazio che già occupa, compreso quello riservato, viene sempre riscritto sul posto, e lo spazio che non utilizza resta
+		 * riservato. Un valore nullo disabilita la riserva. Lo spazio riservato viene rilasciato da compact.
+		 */
+		void update_slack (double ratio) throw ()
+				{__updateSlack = (ratio > 0 ? ratio : 0);}
+
+		static constexpr double default_update_slack = 0.1;
+
+protected:
+		/* __fileName è il percorso del file che contiene i record, __fd è il descrittore del file, aperto per l'intera vita dell'oggetto, e __fileEnd è l'offset
+		 * del primo byte successivo all'ultimo record scritto, ossia la posizione alla quale avvengono le operazioni di append.
+		 */
+		std::string		__fileName;
+		int				__fd;
+		std::streamoff	__fileEnd;
+
+		/* Un segmento descrive la porzione di file occupata da un record, dal byte begin al byte end compresi. I slack byte successivi ad end sono riservati al
+		 * record, in modo che possa crescere senza essere spostato (vedi update_slack). Il segmento mantiene inoltre una copia dello stato e della visibilità del
+		 * record, aggiornata da insert, update e cancel, in modo che le funzioni state e visible non debbano leggere il record dal file.
 		 */
 		struct segment {
-				segment() : begin(0), end(0) {}
-				std::streampos begin;
-				std::streampos end;
+				segment() : begin(0), end(0), slack(0), state(record::empty), visible(false) {}
+				std::streampos		begin;
+				std::streampos		end;
+				std::streamoff		slack;
+				enum record::state	state;
+				bool				visible;
 				std::streamoff size() const {return end - begin + (std::streamoff)1;}
+				void mark (const record& _record) {state = _record.state(); visible = _record.visible();}
 		};
+
+		/* La funzione reserve dimensiona l'indice in modo che possa contenere, senza essere riorganizzato, ulteriori records record.
+		 */
+		void reserve (unsigned long records) throw ()
+				{__recordMap.reserve(__recordMap.size() + records);}
+
+		/* La funzione get_segment restituisce il segmento di file occupato dal record con chiave ID. Se il record non esiste viene generata una eccezione di tipo
+		 * record_not_exists.
+		 */
+		const segment& get_segment (unsigned long ID) const throw (storage_exception&);
+
+		/* Le funzioni write, append e read effettuano l'I/O di un record. Il record viene serializzato in un buffer, e il buffer viene scritto o letto con una singola
+		 * chiamata pwrite/pread all'offset del segmento, senza riaprire il file e senza spostare alcun cursore condiviso.
+		 * La funzione append scrive il record in coda al file, seguito dallo spazio riservato _segment.slack, aggiornando __fileEnd, e restituisce in _segment
+		 * la posizione occupata.
+		 * Viene generata una eccezione di tipo io_error se la dimensione dei dati scritti-letti non coincide con la dimensione del segmento.
+		 * Le tre funzioni sono virtuali, in modo che una classe derivata possa sostituire il meccanismo di I/O (vedi mmap_storage.hpp) riutilizzando la gestione
+		 * dell'indice e del cestino.
+		 */
+		virtual void write (const record& _record, const segment _segment) const throw (storage_exception&);
+		virtual void append (const record& _record, segment& _segment) throw (storage_exception&);
+		virtual void read (record& _record, const segment _segment) const throw (storage_exception&);
+
+		/* La seconda versione della funzione read legge i record occupati dai segmenti contenuti in segments, usando l'anello __ring se disponibile. I record
+		 * vengono restituiti in records, nello stesso ordine dei segmenti.
+		 */
+		virtual void read (std::vector<record>& records, const std::vector<segment>& segments) const throw (storage_exception&);
+
+		/* La funzione window restituisce l'indirizzo dei byte del file compresi tra gli offset begin ed end, estremi inclusi, letti in buffer se necessario;
+		 * l'indirizzo resta valido fino alla successiva modifica di buffer o del file. È utilizzata da scan, ed è virtuale per lo stesso motivo di read.
+		 * Viene generata una eccezione di tipo io_error se non è possibile leggere i byte.
+		 */
+		virtual const char* window (std::streamoff begin, std::streamoff end, std::string& buffer) const throw (storage_exception&);
+
+		/* La funzione move sposta i byte byte che iniziano all'offset from all'offset to, con to minore di from; le due regioni possono sovrapporsi. La funzione
+		 * truncate riporta il file alla dimensione __fileEnd. Sono utilizzate da compact, e sono virtuali per lo stesso motivo di write, append e read.
+		 * Viene generata una eccezione di tipo io_error in caso di errore.
+		 */
+		virtual void move (std::streamoff from, std::streamoff to, std::streamoff byte) throw (storage_exception&);
+		virtual void truncate () throw (storage_exception&);
+
+private:
 		std::unordered_map<unsigned long, segment>	__recordMap;
+		std::string									__epoch;
+		bool										__persistent;		/*	true se l'indice deve essere scritto in coda al file alla distruzione dell'oggetto	*/
+		mutable std::unique_ptr<io_ring>			__ring;				/*	anello io_uring utilizzato da fetch, creato alla prima chiamata	*/
+		mutable record_cache						__cache;
+		bool										__bulk;				/*	true durante un caricamento massivo (vedi begin_bulk)	*/
+		mutable std::string							__bulkBuffer;		/*	record accodati e non ancora scritti, che terminano all'offset __fileEnd	*/
 
-		/*
- 		 */
-		std::unique_ptr<record>	get_record (unsigned long ID) const throw (storage_exception&);
+		/* La funzione flush scrive sul file i record accumulati in __bulkBuffer. Viene generata una eccezione di tipo io_error se la scrittura non va a buon fine.
+		 */
+		void flush () const throw (storage_exception&);
 
-		/*
+		/* La funzione bulk_append aggiunge all'indice, con una nuova chiave, il record di stato _state appena accodato a __bulkBuffer, che ne occupa gli ultimi
+		 * byte byte, e ne restituisce la chiave. La funzione place scrive il record _record, con una nuova chiave, in uno spazio libero o in coda al file, lo
+		 * inserisce nella cache e ne restituisce la chiave.
+		 * La funzione rewrite, usata da update e cancel, sostituisce il record con chiave ID con _record: sul posto se la nuova codifica entra nello spazio
+		 * occupato dal record, compreso lo spazio riservato, altrimenti in uno spazio libero o in coda al file, rilasciando il segmento precedente.
+		 * In tutti i casi l'indice, lo stato e la cache vengono aggiornati solo dopo che il record è stato scritto: se la scrittura genera una eccezione
+		 * l'indice continua a descrivere il record precedente.
 		 */
-		void write (const record& _record, const segment _segment) const throw (storage_exception&);
-		void append (const record& _record, segment& _segment) throw (storage_exception&);
-		void read (record& _record, const segment _segment) const throw (storage_exception&);
+		unsigned long bulk_append (std::size_t byte, enum record::state _state) throw (storage_exception&);
+		unsigned long place (record& _record) throw (storage_exception&);
+		void rewrite (unsigned long ID, record& _record) throw (storage_exception&);
 
-		/*
+		/* La funzione sorted restituisce, in order, i segmenti occupati dai record ordinati per offset.
 		 */
-		std::unordered_map<unsigned long, segment> __trash;
-		unsigned long __trashID;
+		void sorted (std::vector<std::pair<std::streamoff, segment*>>& order) throw ();
 
-		/*
+		/* La funzione load_index legge l'indice scritto in coda al file da store_index, ricostruisce __recordMap e, a partire dagli spazi tra un record e
+		 * l'altro, il cestino; infine rimuove l'indice dal file. Restituisce false, senza modificare l'oggetto, se l'indice non esiste o non è valido.
+		 * La funzione store_index accoda al file l'indice dei record, seguito da una coda di dimensione fissa che contiene la dimensione dell'indice, un
+		 * checksum, la versione del formato e un identificativo.
 		 */
-		void pushTrash	(segment _segment);
-		unsigned long recycle (std::streamoff byte) const;
-		segment popTrash (unsigned long id, std::streamoff byte);
+		bool load_index () throw ();
+		void store_index () const throw ();
 
+		/*
+ 		 */
+		std::unique_ptr<record>	get_record (unsigned long ID) const throw (storage_exception&);
 
+		/* Lo spazio rilasciato dai record modificati o cancellati viene gestito dall'oggetto __trash (vedi trash.hpp).
+		 * La funzione pushTrash rilascia un segmento, compreso lo spazio riservato. La funzione recycle cerca, tra i segmenti rilasciati, il più piccolo in grado di
+		 * contenere byte byte più lo spazio riservato _segment.slack: se esiste, restituisce true e la posizione dello spazio riutilizzato in _segment,
+		 * altrimenti restituisce false.
+		 */
+		trash __trash;
+
+		void pushTrash	(segment _segment) throw ()
+			{__trash.push(_segment.begin, (std::streamoff) _segment.end + _segment.slack);}
+		bool recycle (std::streamoff byte, segment& _segment) throw ();
 
+		double			__compactionRatio;
+		std::streamoff	__compactionMinimum;
+		double			__updateSlack;
 
+		/* La funzione autocompact chiama compact se lo spazio libero supera la soglia stabilita con compaction_policy.
+		 */
+		void autocompact () throw (storage_exception&);
 };
 }; /*	end of openDB namespace	*/
 #endif
@@ -0,0 +1,201 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "hybrid_storage.hpp"
+using namespace openDB;
+
+std::size_t hybrid_storage::__globalBudget = 0;
+std::size_t hybrid_storage::__globalBytes = 0;
+
+hybrid_storage::hybrid_storage(std::string fileName, std::size_t budget) throw (storage_exception&) : storage(), __spill(fileName), __bytes(0), __budget(budget),
+	__faults(0), __evictions(0), __writes(0) {
+	__spill.cache_size(0);
+}
+
+hybrid_storage::~hybrid_storage() {
+	__globalBytes -= __bytes;
+}
+
+std::unique_ptr<std::list<unsigned long>> hybrid_storage::internalID () const throw () {
+	std::unique_ptr<std::list<unsigned long>> ptr(new std::list<unsigned long>);
+	for (std::unordered_map <unsigned long, entry>::const_iterator it = __recordMap.begin(); it != __recordMap.end(); it++)
+		ptr -> push_back(it -> first);
+	return ptr;
+}
+
+void hybrid_storage::clear () throw () {
+	__spill.clear();
+	__recordMap.clear();
+	__spillMap.clear();
+	__lru.clear();
+	__pending.clear();
+	resize(-(std::streamoff) __bytes);
+	__lastKey = 0;
+	__faults = 0;
+	__evictions = 0;
+	__writes = 0;
+}
+
+unsigned long hybrid_storage::insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) {
+	return admit(std::unique_ptr<record>(new record(valuesMap, columnsMap, _state)));
+}
+
+unsigned long hybrid_storage::insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) {
+	unsigned long first = __lastKey;
+	for (std::size_t row = 0; row < _batch.rows(); row++)
+		admit(std::unique_ptr<record>(new record(_batch, row, _state)));
+	return first;
+}
+
+unsigned long hybrid_storage::admit (std::unique_ptr<record> record_ptr) throw (storage_exception&) {
+	unsigned long ID = __lastKey++;
+	entry& _entry = __recordMap[ID];
+	_entry._record = std::move(record_ptr);
+	track(ID, _entry._record->state());
+	__lru.push_front(ID);
+	_entry.lru = __lru.begin();
+	resize(_entry._record->footprint());
+	evict(ID);
+	return ID;
+}
+
+void hybrid_storage::update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) {
+	entry& _entry = resident(ID);
+	std::streamoff before = _entry._record->footprint();
+	_entry._record->update(valuesMap, columnsMap);
+	track(ID, _entry._record->state());
+	modified(ID, _entry, before);
+}
+
+void hybrid_storage::cancel (unsigned long ID) throw (storage_exception&) {
+	entry& _entry = resident(ID);
+	std::streamoff before = _entry._record->footprint();
+	_entry._record->cancel();
+	track(ID, record::deleting);
+	modified(ID, _entry, before);
+}
+
+void hybrid_storage::erase (unsigned long ID) throw (storage_exception&) {
+	entry& _entry = get_entry(ID);
+	if (_entry.copy) {
+		__spill.erase(_entry.spillID);
+		__spillMap.erase(_entry.spillID);
+	}
+	if (_entry._record)
+		drop(_entry);
+	__recordMap.erase(ID);
+	untrack(ID);
+}
+
+enum record::state hybrid_storage::state (unsigned long ID) const throw (storage_exception&) {
+	const entry& _entry = get_entry(ID);
+	return (_entry._record ? _entry._record->state() : __spill.state(_entry.spillID));
+}
+
+bool hybrid_storage::visible (unsigned long ID) const throw (storage_exception&) {
+	const entry& _entry = get_entry(ID);
+	return (_entry._record ? _entry._record->visible() : __spill.visible(_entry.spillID));
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> hybrid_storage::current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&) {
+	const entry& _entry = get_entry(ID);
+	return (_entry._record ? _entry._record->current(columns) : __spill.current(_entry.spillID, columns));
+}
+
+void hybrid_storage::scan (visitor& _visitor) const throw (basic_exception&) {
+	for (std::unordered_map<unsigned long, entry>::const_iterator it = __recordMap.begin(); it != __recordMap.end(); it++)
+		if (it->second._record)
+			_visitor.visit(it->first, *it->second._record);
+
+	class spilled : public visitor {
+	public :
+		spilled (visitor& _visitor, const std::unordered_map<unsigned long, entry>& recordMap, const std::unordered_map<unsigned long, unsigned long>& spillMap) :
+			__visitor(_visitor), __recordMap(recordMap), __spillMap(spillMap) {}
+		virtual void visit (unsigned long spillID, const record& _record) throw (basic_exception&) {
+			unsigned long ID = __spillMap.find(spillID)->second;
+			if (!__recordMap.find(ID)->second._record)		//i record in memoria sono già stati visitati
+				__visitor.visit(ID, _record);
+		}
+	private :
+		visitor& __visitor;
+		const std::unordered_map<unsigned long, entry>& __recordMap;
+		const std::unordered_map<unsigned long, unsigned long>& __spillMap;
+	} spilled_visitor(_visitor, __recordMap, __spillMap);
+	__spill.scan(spilled_visitor);
+}
+
+hybrid_storage::statistics hybrid_storage::stats () const throw () {
+	statistics _stats;
+	_stats.resident = __lru.size();
+	_stats.spilled = __recordMap.size() - __lru.size();
+	_stats.bytes = __bytes;
+	_stats.faults = __faults;
+	_stats.evictions = __evictions;
+	_stats.writes = __writes;
+	return _stats;
+}
+
+hybrid_storage::entry& hybrid_storage::get_entry (unsigned long ID) const throw (storage_exception&) {
+	std::unordered_map<unsigned long, entry>::iterator it = __recordMap.find(ID);
+	if (it == __recordMap.end())
+		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
+	return it->second;
+}
+
+hybrid_storage::entry& hybrid_storage::resident (unsigned long ID) const throw (storage_exception&) {
+	entry& _entry = get_entry(ID);
+	if (_entry._record) {
+		__lru.splice(__lru.begin(), __lru, _entry.lru);
+		return _entry;
+	}
+	_entry._record = __spill.retrieve(_entry.spillID);
+	__faults++;
+	__lru.push_front(ID);
+	_entry.lru = __lru.begin();
+	resize(_entry._record->footprint());
+	evict(ID);
+	return _entry;
+}
+
+void hybrid_storage::modified (unsigned long ID, entry& _entry, std::streamoff before) throw (storage_exception&) {
+	if (_entry.copy) {
+		__spill.erase(_entry.spillID);
+		__spillMap.erase(_entry.spillID);
+		_entry.copy = false;
+	}
+	resize((std::streamoff) _entry._record->footprint() - before);
+	evict(ID);
+}
+
+void hybrid_storage::resize (std::streamoff delta) const throw () {
+	__bytes += delta;
+	__globalBytes += delta;
+}
+
+void hybrid_storage::evict (unsigned long keep) const throw (storage_exception&) {
+	while (!__lru.empty() && __lru.back() != keep && (__bytes > __budget || (__globalBudget > 0 && __globalBytes > __globalBudget))) {
+		entry& _entry = __recordMap.find(__lru.back())->second;
+		if (!_entry.copy) {		//un record che ha già una copia su file non modificata non viene riscritto
+			_entry.spillID = __spill.store(*_entry._record);
+			_entry.copy = true;
+			__spillMap.insert(std::pair<unsigned long, unsigned long>(_entry.spillID, __lru.back()));
+			__writes++;
+		}
+		drop(_entry);
+		__evictions++;
+	}
+}
+
+void hybrid_storage::drop (entry& _entry) const throw () {
+	resize(-(std::streamoff) _entry._record->footprint());
+	__lru.erase(_entry.lru);
+	_entry._record.reset();
+}
@@ -0,0 +1,160 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_HYBRID_STORAGE_HEADER__
+#define __OPENDB_HYBRID_STORAGE_HEADER__
+
+#include "file_storage.hpp"
+
+namespace openDB{
+/* La classe hybrid_storage mantiene i record in memoria, come memory_storage, finchè i byte che occupano non superano un limite stabilito; oltre il limite i
+ * record usati meno di recente (LRU) vengono spostati su un file, gestito da un oggetto file_storage, e vengono riportati in memoria automaticamente quando
+ * si accede ad essi. In questo modo una tabella piccola viene gestita interamente in memoria, mentre una tabella grande occupa al più la memoria stabilita,
+ * senza che sia necessario scegliere il gestore tabella per tabella.
+ * La memoria occupata da ciascun record viene stimata con la funzione record::footprint.
+ * Un record riportato in memoria conserva la propria copia su file finchè non viene modificato, per cui, se deve essere nuovamente rimosso dalla memoria,
+ * non deve essere riscritto.
+ * Il limite può essere stabilito per ciascun oggetto e per l'insieme di tutti gli oggetti hybrid_storage (vedi global_budget): un oggetto sposta su file i
+ * propri record quando supera il proprio limite oppure quando l'insieme degli oggetti supera il limite globale.
+ */
+class hybrid_storage : public storage {
+public:
+		/* Il costruttore crea il file fileName, troncandolo se esiste già, nel quale vengono spostati i record quando i byte occupati in memoria superano
+		 * budget. Se non è possibile creare il file viene generata una eccezione di tipo file_creation. I record non vengono conservati tra una esecuzione e la
+		 * successiva.
+		 */
+		hybrid_storage(std::string fileName, std::size_t budget = default_budget) throw (storage_exception&);
+		virtual ~hybrid_storage();
+
+		hybrid_storage(const hybrid_storage&) = delete;
+		hybrid_storage& operator= (const hybrid_storage&) = delete;
+
+		/* Vedi storage.hpp.
+		 */
+		virtual std::unique_ptr<std::list<unsigned long>> internalID () const throw ();
+		virtual unsigned long numRecords () const throw ()
+				{return __recordMap.size();}
+		virtual void clear () throw ();
+		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&);
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&);
+		virtual void update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&);
+		virtual void cancel (unsigned long ID) throw (storage_exception&);
+		virtual void erase (unsigned long ID) throw (storage_exception&);
+		virtual enum record::state state (unsigned long ID) const throw (storage_exception&);
+		virtual bool visible (unsigned long ID)	const throw (storage_exception&);
+
+		/* Le funzioni current e old riportano in memoria il record, se si trova su file, marcandolo come il più recente. Possono generare una eccezione di tipo
+		 * record_not_exists, se il record non esiste, o io_error, se non è possibile leggerlo o spostare su file altri record per fargli spazio.
+		 */
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&)
+				{return resident(ID)._record->current();}
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&)
+				{return resident(ID)._record->old();}
+
+		/* La seconda versione della funzione current non riporta in memoria il record se si trova su file: i valori richiesti vengono decodificati direttamente
+		 * dal file (vedi file_storage.hpp).
+		 */
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&);
+
+		/* La funzione scan visita prima i record in memoria e poi quelli su file, nell'ordine in cui si trovano nel file (vedi file_storage::scan), senza
+		 * riportarli in memoria. Vedi storage.hpp.
+		 */
+		virtual void scan (visitor& _visitor) const throw (basic_exception&);
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&)
+				{_visitor.visit(ID, *resident(ID)._record);}
+		virtual std::unique_ptr<cursor> rows () const throw ()
+				{return std::unique_ptr<cursor>(new key_cursor<std::unordered_map<unsigned long, entry>::const_iterator>(*this, __recordMap.begin(), __recordMap.end()));}
+
+		/* Durante un caricamento massivo i record spostati su file vengono scritti a blocchi (vedi file_storage::begin_bulk).
+		 */
+		virtual void begin_bulk (unsigned long records = 0) throw ()
+				{__recordMap.reserve(__recordMap.size() + records); __spill.begin_bulk();}
+		virtual void end_bulk () throw (storage_exception&)
+				{__spill.end_bulk();}
+
+		/* La funzione budget modifica il numero massimo di byte occupati in memoria dall'oggetto; i record in eccesso vengono spostati su file al successivo
+		 * accesso. La funzione global_budget modifica il numero massimo di byte occupati in memoria dall'insieme degli oggetti hybrid_storage; un valore nullo,
+		 * quello di default, lo disabilita.
+		 */
+		void budget (std::size_t _budget) throw ()
+				{__budget = _budget;}
+		static void global_budget (std::size_t _budget) throw ()
+				{__globalBudget = _budget;}
+
+		/* La struttura statistics raccoglie i contatori relativi all'utilizzo della memoria:
+		 * 	- resident: numero di record in memoria;
+		 * 	- spilled: numero di record che si trovano solo su file;
+		 * 	- bytes: byte occupati in memoria dai record;
+		 * 	- faults: numero di record riportati in memoria;
+		 * 	- evictions: numero di record rimossi dalla memoria;
+		 * 	- writes: numero di record scritti su file, inferiore a evictions se alcuni record sono stati rimossi senza essere stati modificati.
+		 */
+		struct statistics {
+				std::size_t		resident;
+				std::size_t		spilled;
+				std::size_t		bytes;
+				unsigned long	faults;
+				unsigned long	evictions;
+				unsigned long	writes;
+				statistics() : resident(0), spilled(0), bytes(0), faults(0), evictions(0), writes(0) {}
+		};
+		statistics stats () const throw ();
+
+		static const std::size_t default_budget = 67108864;		/*	64 MiB	*/
+
+private:
+		/* Per ciascun record l'indice contiene il record, se si trova in memoria, la sua posizione nella lista LRU e, se il record ha una copia su file, la
+		 * chiave con cui la copia è memorizzata da __spill.
+		 */
+		struct entry {
+				entry() : copy(false), spillID(0) {}
+				std::unique_ptr<record>				_record;
+				std::list<unsigned long>::iterator	lru;
+				bool								copy;
+				unsigned long						spillID;
+		};
+
+		mutable file_storage								__spill;
+		mutable std::unordered_map<unsigned long, entry>	__recordMap;
+		mutable std::unordered_map<unsigned long, unsigned long>	__spillMap;		/*	chiave della copia su file -> chiave del record	*/
+		mutable std::list<unsigned long>					__lru;			/*	chiavi dei record in memoria, dal più recente al meno recente	*/
+		mutable std::size_t									__bytes;
+		std::size_t											__budget;
+		mutable unsigned long								__faults;
+		mutable unsigned long								__evictions;
+		mutable unsigned long								__writes;
+
+		static std::size_t									__globalBudget;
+		static std::size_t									__globalBytes;
+
+		entry& get_entry (unsigned long ID) const throw (storage_exception&);
+
+		/* La funzione resident restituisce l'elemento dell'indice relativo al record con chiave ID, riportando il record in memoria se necessario, e lo marca
+		 * come il più recente. La funzione modified rimuove la copia su file del record, che non è più valida, e aggiorna i byte occupati in memoria dopo una
+		 * modifica; before è la dimensione del record prima della modifica.
+		 */
+		entry& resident (unsigned long ID) const throw (storage_exception&);
+		void modified (unsigned long ID, entry& _entry, std::streamoff before) throw (storage_exception&);
+
+		/* La funzione resize aggiunge delta ai byte occupati in memoria. La funzione evict sposta su file i record usati meno di recente finchè i byte occupati
+		 * non rientrano nei limiti, senza mai rimuovere il record keep.
+		 */
+		void resize (std::streamoff delta) const throw ();
+
+		/* La funzione admit aggiunge all'indice, con una nuova chiave, il record appena costruito e lo marca come il più recente, spostando su file i record
+		 * usati meno di recente se necessario. Restituisce la chiave del record.
+		 */
+		unsigned long admit (std::unique_ptr<record> record_ptr) throw (storage_exception&);
+		void evict (unsigned long keep) const throw (storage_exception&);
+		void drop (entry& _entry) const throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
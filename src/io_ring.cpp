@@ -0,0 +1,156 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "io_ring.hpp"
+
+#if defined __linux__ && defined __has_include
+	#if __has_include(<linux/io_uring.h>)
+		#define __OPENDB_IO_URING__
+	#endif
+#endif
+
+#if defined __OPENDB_IO_URING__
+	#include <linux/io_uring.h>
+	#include <sys/syscall.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include <cstring>
+#endif
+
+using namespace openDB;
+
+#if defined __OPENDB_IO_URING__
+
+io_ring::io_ring (unsigned depth) throw () : __ring(-1), __sqMap(MAP_FAILED), __sqMapSize(0), __cqMap(MAP_FAILED), __cqMapSize(0), __sqes(MAP_FAILED), __sqesSize(0),
+	__sqEntries(0), __sqHead(0), __sqTail(0), __sqMask(0), __sqArray(0), __cqHead(0), __cqTail(0), __cqMask(0), __cqes(0) {
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	__ring = syscall(__NR_io_uring_setup, depth, &params);
+	if (__ring < 0)
+		return;
+	__sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	__cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)		//i due anelli condividono la stessa proiezione
+		__sqMapSize = __cqMapSize = (__sqMapSize > __cqMapSize ? __sqMapSize : __cqMapSize);
+	__sqMap = mmap(0, __sqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, __ring, IORING_OFF_SQ_RING);
+	if (__sqMap == MAP_FAILED) {
+		release();
+		return;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		__cqMap = __sqMap;
+	else {
+		__cqMap = mmap(0, __cqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, __ring, IORING_OFF_CQ_RING);
+		if (__cqMap == MAP_FAILED) {
+			release();
+			return;
+		}
+	}
+	__sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	__sqes = mmap(0, __sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, __ring, IORING_OFF_SQES);
+	if (__sqes == MAP_FAILED) {
+		release();
+		return;
+	}
+	char* sq = static_cast<char*> (__sqMap);
+	char* cq = static_cast<char*> (__cqMap);
+	__sqEntries = params.sq_entries;
+	__sqHead = reinterpret_cast<unsigned*> (sq + params.sq_off.head);
+	__sqTail = reinterpret_cast<unsigned*> (sq + params.sq_off.tail);
+	__sqMask = reinterpret_cast<unsigned*> (sq + params.sq_off.ring_mask);
+	__sqArray = reinterpret_cast<unsigned*> (sq + params.sq_off.array);
+	__cqHead = reinterpret_cast<unsigned*> (cq + params.cq_off.head);
+	__cqTail = reinterpret_cast<unsigned*> (cq + params.cq_off.tail);
+	__cqMask = reinterpret_cast<unsigned*> (cq + params.cq_off.ring_mask);
+	__cqes = cq + params.cq_off.cqes;
+}
+
+io_ring::~io_ring() {
+	release();
+}
+
+void io_ring::release () throw () {
+	if (__sqes != MAP_FAILED)
+		munmap(__sqes, __sqesSize);
+	if (__cqMap != MAP_FAILED && __cqMap != __sqMap)
+		munmap(__cqMap, __cqMapSize);
+	if (__sqMap != MAP_FAILED)
+		munmap(__sqMap, __sqMapSize);
+	if (__ring >= 0)
+		close(__ring);
+	__sqes = __cqMap = __sqMap = MAP_FAILED;
+	__ring = -1;
+}
+
+bool io_ring::read (int fd, std::vector<request>& requests) throw () {
+	if (__ring < 0)
+		return false;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*> (__sqes);
+	io_uring_cqe* cqes = static_cast<io_uring_cqe*> (__cqes);
+	std::size_t next = 0, completed = 0, inflight = 0;
+	bool failed = false;
+	while (completed < requests.size() && !(failed && inflight == 0)) {
+		unsigned tail = *__sqTail;
+		while (!failed && next < requests.size() && inflight < __sqEntries && tail - __atomic_load_n(__sqHead, __ATOMIC_ACQUIRE) < __sqEntries) {
+			unsigned index = tail & *__sqMask;
+			io_uring_sqe& sqe = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_READ;
+			sqe.fd = fd;
+			sqe.addr = reinterpret_cast<unsigned long> (requests[next].buffer);
+			sqe.len = requests[next].count;
+			sqe.off = requests[next].offset;
+			sqe.user_data = next;
+			__sqArray[index] = index;
+			tail++;
+			next++;
+			inflight++;
+		}
+		__atomic_store_n(__sqTail, tail, __ATOMIC_RELEASE);
+		unsigned pending = tail - __atomic_load_n(__sqHead, __ATOMIC_ACQUIRE);
+		if (syscall(__NR_io_uring_enter, __ring, pending, 1, IORING_ENTER_GETEVENTS, 0, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			if (failed) {		//non è possibile attendere le letture in corso: l'anello viene chiuso
+				release();
+				return false;
+			}
+			failed = true;		//le richieste non ancora prese in carico dal kernel vengono ritirate, quelle in corso vengono attese
+			unsigned head = __atomic_load_n(__sqHead, __ATOMIC_ACQUIRE);
+			inflight -= *__sqTail - head;
+			__atomic_store_n(__sqTail, head, __ATOMIC_RELEASE);
+		}
+		unsigned head = *__cqHead;
+		unsigned cqTail = __atomic_load_n(__cqTail, __ATOMIC_ACQUIRE);
+		for (; head != cqTail; head++) {
+			io_uring_cqe& cqe = cqes[head & *__cqMask];
+			requests[cqe.user_data].result = cqe.res;
+			completed++;
+			inflight--;
+		}
+		__atomic_store_n(__cqHead, head, __ATOMIC_RELEASE);
+	}
+	return !failed;
+}
+
+#else
+
+io_ring::io_ring (unsigned) throw () : __ring(-1), __sqMap(0), __sqMapSize(0), __cqMap(0), __cqMapSize(0), __sqes(0), __sqesSize(0),
+	__sqEntries(0), __sqHead(0), __sqTail(0), __sqMask(0), __sqArray(0), __cqHead(0), __cqTail(0), __cqMask(0), __cqes(0) {}
+
+io_ring::~io_ring() {}
+
+void io_ring::release () throw () {}
+
+bool io_ring::read (int, std::vector<request>&) throw () {
+	return false;
+}
+
+#endif
@@ -0,0 +1,82 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_IO_RING_HEADER__
+#define __OPENDB_IO_RING_HEADER__
+
+#include <vector>
+#include <cstddef>
+#include <ios>
+
+namespace openDB {
+/* La classe io_ring consente di effettuare molte letture posizionali con poche chiamate di sistema, attraverso l'interfaccia io_uring del kernel Linux: le
+ * richieste vengono accodate in un anello condiviso con il kernel, fino a depth alla volta, e i risultati vengono raccolti a blocchi, senza attendere il
+ * completamento di ciascuna lettura prima di avviare la successiva.
+ * L'interfaccia viene utilizzata direttamente attraverso le chiamate di sistema io_uring_setup e io_uring_enter, senza dipendere da librerie esterne. Se il
+ * sistema non la supporta (kernel non Linux o precedente alla versione 5.6, oppure chiamate di sistema non consentite) l'oggetto non è utilizzabile, la
+ * funzione ready restituisce false e il chiamante deve effettuare le letture in modo sincrono (vedi file_storage.hpp).
+ * Un oggetto io_ring non può essere usato contemporaneamente da più thread.
+ */
+class io_ring {
+public:
+		/* La struttura request descrive una lettura: count byte a partire dall'offset offset, da copiare in buffer. Al termine della lettura result contiene il
+		 * numero di byte letti oppure, se negativo, il codice di errore cambiato di segno.
+		 */
+		struct request {
+				char*			buffer;
+				std::size_t		count;
+				std::streamoff	offset;
+				long			result;
+		};
+
+		/* Il costruttore crea un anello in grado di gestire depth richieste contemporaneamente. Il distruttore lo rilascia.
+		 */
+		explicit io_ring (unsigned depth = default_depth) throw ();
+		~io_ring();
+
+		io_ring(const io_ring&) = delete;
+		io_ring& operator= (const io_ring&) = delete;
+
+		/* La funzione ready restituisce true se l'anello è stato creato correttamente e può essere utilizzato.
+		 */
+		bool ready () const throw ()
+			{return __ring >= 0;}
+
+		/* La funzione read effettua le letture descritte da requests sul file fd, e restituisce quando tutte sono terminate. Il risultato di ciascuna lettura viene
+		 * riportato nel campo result della relativa richiesta: una lettura può restituire meno byte di quelli richiesti, ed è compito del chiamante completarla.
+		 * Restituisce false, lasciando indefiniti i risultati, se l'anello non è utilizzabile o se il kernel rifiuta le richieste.
+		 */
+		bool read (int fd, std::vector<request>& requests) throw ();
+
+		static const unsigned default_depth = 64;
+
+private:
+		int				__ring;			/*	descrittore dell'anello	*/
+		void*			__sqMap;		/*	proiezione dell'anello delle richieste (submission queue)	*/
+		std::size_t		__sqMapSize;
+		void*			__cqMap;		/*	proiezione dell'anello dei completamenti (completion queue), coincide con __sqMap se il kernel lo consente	*/
+		std::size_t		__cqMapSize;
+		void*			__sqes;			/*	vettore delle richieste	*/
+		std::size_t		__sqesSize;
+		unsigned		__sqEntries;
+		unsigned*		__sqHead;
+		unsigned*		__sqTail;
+		unsigned*		__sqMask;
+		unsigned*		__sqArray;
+		unsigned*		__cqHead;
+		unsigned*		__cqTail;
+		unsigned*		__cqMask;
+		void*			__cqes;
+
+		void release () throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
@@ -11,31 +11,66 @@
  */
 
 #include "memory_storage.hpp"
+#include <algorithm>
 using namespace openDB;
 
 std::unique_ptr<std::list<unsigned long>> memory_storage::internalID () const throw () {
 	std::unique_ptr<std::list<unsigned long>> list_ptr (new std::list<unsigned long>);
-	for (std::unordered_map<unsigned long, record>::const_iterator it = __recordMap.begin(); it!= __recordMap.end(); it++)
+	for (record_map::const_iterator it = __recordMap.begin(); it!= __recordMap.end(); it++)
 		list_ptr->push_back(it->first);
 	return list_ptr;
 }
 
+void memory_storage::scan (visitor& _visitor) const throw (basic_exception&) {
+	for (record_map::const_iterator it = __recordMap.begin(); it!= __recordMap.end(); it++)
+		_visitor.visit(it->first, it->second);
+}
+
+void memory_storage::visit_morsel (std::size_t morsel, visitor& _visitor) const throw (basic_exception&) {
+	std::size_t last = std::min((morsel + 1) * morsel_rows, __recordMap.bucket_count());
+	for (std::size_t bucket = morsel * morsel_rows; bucket < last; bucket++)
+		for (record_map::const_local_iterator it = __recordMap.begin(bucket); it != __recordMap.end(bucket); it++)
+			_visitor.visit(it->first, it->second);
+}
+
 unsigned long memory_storage::insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) {
-	record _record(valuesMap, columnsMap, _state);
-	__recordMap.insert(std::pair<unsigned long, record>(__lastKey, _record));
+	record _record(valuesMap, columnsMap, _state, (__monotonic ? &__arena : 0), (__encode ? &__dictionary : 0));
+	__recordMap.emplace(__lastKey, std::move(_record));
+	track(__lastKey, _state);
 	return __lastKey++;
 }
 
+unsigned long memory_storage::insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) {
+	unsigned long first = __lastKey;
+	for (std::size_t row = 0; row < _batch.rows(); row++) {
+		record _record(_batch, row, _state, (__monotonic ? &__arena : 0), (__encode ? &__dictionary : 0));
+		track(__lastKey, _state);
+		__recordMap.emplace(__lastKey++, std::move(_record));
+	}
+	return first;
+}
+
+void memory_storage::clear () throw () {
+	// la tabella dei bucket può essere allocata nell'arena, per cui la corrispondenza viene distrutta prima di svuotare l'arena ed il dizionario
+	__recordMap = record_map(0, std::hash<unsigned long>(), std::equal_to<unsigned long>(), allocator());
+	__arena.clear();
+	__dictionary.clear();
+	__pending.clear();
+	__lastKey = 0;
+}
+
 void memory_storage::erase (unsigned long ID) throw (storage_exception&) {
-	std::unordered_map<unsigned long, record>::iterator it = __recordMap.find(ID);
-	if (it != __recordMap.end())
+	record_map::iterator it = __recordMap.find(ID);
+	if (it != __recordMap.end()) {
 		__recordMap.erase(it);
+		untrack(ID);
+	}
 	else
 		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
 }
 
 const record& memory_storage::get_record(unsigned long ID) const throw (storage_exception&) {
-	std::unordered_map<unsigned long, record>::const_iterator it = __recordMap.find(ID);
+	record_map::const_iterator it = __recordMap.find(ID);
 	if (it != __recordMap.end())
 		return it->second;
 	else
@@ -43,7 +78,7 @@ const record& memory_storage::get_record(unsigned long ID) const throw (storage_
 }
 
 record& memory_storage::get_record(unsigned long ID) throw (storage_exception&) {
-	std::unordered_map<unsigned long, record>::iterator it = __recordMap.find(ID);
+	record_map::iterator it = __recordMap.find(ID);
 	if (it != __recordMap.end())
 		return it->second;
 	else
@@ -14,17 +14,27 @@
 #define __OPENDB_MEMORY_STORAGE_HEADER__
 
 #include "storage.hpp"
+#include "dictionary.hpp"
 
 namespace openDB{
 /* La classe memory_storage implementa i meccanismi di memorizzazione delle tuple in memoria Ram. I record sono identificati attraverso una corrispondenza biunivoca del
  * tipo chiave-valore. La chiave per questa corrispondenza permetterà l'accesso al valore corrispondente ed è un campo di tipo unsigned long. L'ultimo numero-chiave
  * generato viene memorizzato nell'attributo __lastKey.
+ * In modalità monotona i record, i nodi della corrispondenza ed i valori che non trovano posto all'interno delle celle vengono allocati in un'arena (vedi
+ * arena.hpp): l'inserimento di un record non richiede allocazioni dinamiche, se non quelle dei blocchi dell'arena, e la funzione clear libera la memoria in
+ * un'unica operazione. La memoria dei record cancellati o aggiornati viene però recuperata soltanto dalla funzione clear, per cui la modalità monotona è
+ * indicata soltanto per le tabelle che vengono caricate una volta e poi lette, come quelle che contengono il risultato di una interrogazione (vedi table.hpp).
+ * Se richiesto, i valori delle colonne varchar e character vengono inoltre codificati con un dizionario (vedi dictionary.hpp), che conserva una sola copia
+ * dei valori ripetuti delle colonne con pochi valori distinti. Anche i valori del dizionario vengono liberati soltanto dalla funzione clear, per cui la
+ * codifica è indicata, come la modalità monotona, soltanto per le tabelle che vengono caricate una volta e poi lette.
  */
 class memory_storage : public storage {
 public :
-		/*
+		/* Il parametro monotonic stabilisce se i record vengono allocati nell'arena o singolarmente, il parametro encode se i valori testuali vengono
+		 * codificati con il dizionario.
 		 */
-		memory_storage() throw () : storage() {};
+		memory_storage(bool monotonic = false, bool encode = false) throw () :
+			storage(), __monotonic(monotonic), __encode(encode), __recordMap(0, std::hash<unsigned long>(), std::equal_to<unsigned long>(), allocator()) {};
 
 		/* La funzione membro 'internalID' restituisce un oggetto std::list di unsigned long, più precisamente un oggetto unique_ptr contenente un puntatore ad un oggetto
 		 * std::list<unsigned long>, che contiene l'elenco delle chiavi generate che sono ancora valide.
@@ -40,8 +50,7 @@ public :
 		/* La funzione clear svuota il gestore, liberando lo spazio occupato dai record e riportando il gestore allo stato in cui si troverebbe se fosse stato appena
 		 * creato.
 		 */
-		virtual void clear () throw ()
-			{__recordMap.clear(); __lastKey = 0;}
+		virtual void clear () throw ();
 
 		/* La funzione insert consente di creare un nuovo record e di inserirlo tra quelli gestiti dal gestore.
 		 * I paramentri sono:
@@ -65,6 +74,7 @@ public :
 		 * 					  valida a causa di un errore dovuto ad un valore non compatibile con il tipo della colonna.
 		 */
 		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&);
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&);
 
 		/* La funzione update consente di marcare i valori di un record affinchè siano aggiornati correttamente dal database remoto. Prende i seguenti parametri:
 		 * consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
@@ -80,14 +90,14 @@ public :
 		 * 					  valida a causa di un errore dovuto ad un valore non compatibile con il tipo della colonna.
 		 */
 		virtual void update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&)
-			{get_record(ID).update(valuesMap, columnsMap);}
+			{record& _record = get_record(ID); _record.update(valuesMap, columnsMap, (__encode ? &__dictionary : 0)); track(ID, _record.state());}
 
 		/* La funzione cancel marca un record affinchè sia rimosso dal database remoto all'atto del commit.
 		 * La funzione può generare una eccezione di tipo 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con la chiave contenuta nel
 		 * parametro ID specifico
 		 */
 		virtual void cancel (unsigned long ID) throw (storage_exception&)
-			{get_record(ID).cancel();}
+			{get_record(ID).cancel(); track(ID, record::deleting);}
 
 		/* La funzione erase rimuove un record dal gestore.
 		 * La funzione può generare una eccezione di tipo 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con la chiave contenuta nel
@@ -128,13 +138,58 @@ public :
 			{return get_record(ID).current();}
 		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&)
 			{return get_record(ID).old();}
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&)
+			{return get_record(ID).current(columns);}
+
+		virtual void scan (visitor& _visitor) const throw (basic_exception&);
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&)
+			{_visitor.visit(ID, get_record(ID));}
+		virtual std::unique_ptr<cursor> rows () const throw ()
+			{return std::unique_ptr<cursor>(new record_cursor(*this, __recordMap.begin(), __recordMap.end()));}
+
+		/* La funzione begin_bulk riserva spazio per records record. */
+		virtual void begin_bulk (unsigned long records) throw ()
+			{__recordMap.reserve(__recordMap.size() + records);}
+
+		virtual arena::statistics allocation_stats () const throw ()
+			{return __arena.stats();}
+		virtual std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>> dictionary_stats () const throw ()
+			{return __dictionary.stats();}
 
 private:
+		typedef arena_allocator<std::pair<const unsigned long, record>> allocator_type;
+		typedef std::unordered_map<unsigned long, record, std::hash<unsigned long>, std::equal_to<unsigned long>, allocator_type> record_map;
+
+		bool		__monotonic;
+		bool		__encode;
+
+		/* L'arena ed il dizionario devono essere dichiarati prima di __recordMap, in modo da essere distrutti dopo di essa. */
+		arena		__arena;
+		dictionary	__dictionary;
+
 		/* La corrispondenza chiave-valore viene implementata attraverso un oggetto di tipo std::unordered_map. I campi dell'oggetto unordered_map sono del tipo
 		 * unsigned long per la chiave e record per il valore. Un oggetto di tipo record (vedi header record.hpp) gestisce le informazioni riguardo una "riga" di
 		 * una tabella.
 		 */
-		std::unordered_map<unsigned long, record> __recordMap;
+		record_map	__recordMap;
+
+		allocator_type allocator () throw ()
+			{return allocator_type(__monotonic ? &__arena : 0);}
+
+		/* Il cursore di memory_storage passa al visitatore il record corrente senza cercarlo nuovamente per chiave. */
+		class record_cursor : public key_cursor<record_map::const_iterator> {
+		public :
+				record_cursor (const storage& _storage, record_map::const_iterator begin, record_map::const_iterator end) throw () : key_cursor<record_map::const_iterator>(_storage, begin, end) {}
+				virtual void visit (visitor& _visitor) const throw (basic_exception&)
+						{_visitor.visit(__ID, __current->second);}
+		};
+
+		/* I blocchi visitati da parallel_scan (vedi storage.hpp) sono gruppi di morsel_rows bucket consecutivi di __recordMap, che contengono in media non
+		 * più di morsel_rows record: la lettura contemporanea di bucket diversi non richiede sincronizzazione.
+		 */
+		virtual std::size_t morsels () const throw ()
+			{return (__recordMap.bucket_count() + morsel_rows - 1) / morsel_rows;}
+		virtual void visit_morsel (std::size_t morsel, visitor& _visitor) const throw (basic_exception&);
 
 		/* Le funzioni get_record consentono l'accesso ai record gestiti dall'oggetto memory_storage. Specificando un valore chiave attraverso il parametro ID si accede
 		 * ad un oggetto record (vedi header record.hpp) che gestisce materialmente le informazioni. S
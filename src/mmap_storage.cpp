@@ -0,0 +1,101 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "mmap_storage.hpp"
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cstring>
+using namespace openDB;
+
+mmap_storage::mmap_storage(std::string fileName, std::streamoff chunk, bool reattach) throw (storage_exception&) :
+	file_storage(fileName, reattach), __map(0), __capacity(0), __chunk(chunk > 0 ? chunk : default_chunk) {
+	try {remap(__fileEnd > 0 ? __fileEnd : __chunk);}
+	catch (storage_exception&) {throw file_creation("Error: '" + __fileName + "' can not be mapped in memory!");}
+}
+
+mmap_storage::~mmap_storage() {
+	if (__map != 0)
+		munmap(__map, __capacity);
+	if (ftruncate(__fd, __fileEnd) != 0) {}		//il file viene riportato alla dimensione effettiva; un eventuale errore non è recuperabile nel distruttore
+}
+
+void mmap_storage::clear () throw () {
+	file_storage::clear();
+	if (ftruncate(__fd, __capacity) != 0) {		//file_storage::clear tronca il file: la proiezione deve rimanere coperta dal file
+		munmap(__map, __capacity);
+		__map = 0;
+		__capacity = 0;
+	}
+}
+
+void mmap_storage::write (const record& _record, const segment _segment) const throw (storage_exception&) {
+	std::string buffer;
+	_record.write(buffer);
+	if ((std::streamoff) buffer.size() != _segment.size() || (std::streamoff) _segment.end >= __capacity)
+		throw io_error("I/O error during write: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	std::memcpy(__map + (std::streamoff) _segment.begin, buffer.data(), buffer.size());
+}
+
+void mmap_storage::append (const record& _record, segment& _segment) throw (storage_exception&) {
+	std::string buffer;
+	_record.write(buffer);
+	if (__fileEnd + (std::streamoff) buffer.size() + _segment.slack > __capacity)
+		remap(__fileEnd + buffer.size() + _segment.slack);
+	std::memcpy(__map + __fileEnd, buffer.data(), buffer.size());
+	_segment.begin = __fileEnd;
+	_segment.end = __fileEnd + (std::streamoff) buffer.size() - (std::streamoff)1;
+	__fileEnd += buffer.size() + _segment.slack;
+	if (_record.size() != _segment.size())
+		throw io_error("I/O error during append: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+}
+
+void mmap_storage::read (record& _record, const segment _segment) const throw (storage_exception&) {
+	if ((std::streamoff) _segment.end >= __fileEnd)
+		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	_record.read(__map + (std::streamoff) _segment.begin, _segment.size());
+}
+
+void mmap_storage::read (std::vector<record>& records, const std::vector<segment>& segments) const throw (storage_exception&) {
+	for (std::size_t i = 0; i < segments.size(); i++)
+		read(records[i], segments[i]);
+}
+
+const char* mmap_storage::window (std::streamoff begin, std::streamoff end, std::string&) const throw (storage_exception&) {
+	if (end >= __fileEnd)
+		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	return __map + begin;
+}
+
+void mmap_storage::move (std::streamoff from, std::streamoff to, std::streamoff byte) throw (storage_exception&) {
+	if (from + byte > __capacity)
+		throw io_error("I/O error during compaction: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	std::memmove(__map + to, __map + from, byte);
+}
+
+void mmap_storage::truncate () throw (storage_exception&) {
+	remap(__fileEnd > 0 ? __fileEnd : 1);
+}
+
+void mmap_storage::remap (std::streamoff byte) throw (storage_exception&) {
+	std::streamoff capacity = ((byte + __chunk - 1) / __chunk) * __chunk;
+	if (ftruncate(__fd, capacity) != 0)
+		throw io_error("I/O error: '" + __fileName + "' can not be extended!");
+	if (__map != 0)
+		munmap(__map, __capacity);
+	void* map = mmap(0, capacity, PROT_READ|PROT_WRITE, MAP_SHARED, __fd, 0);
+	if (map == MAP_FAILED) {
+		__map = 0;
+		__capacity = 0;
+		throw io_error("I/O error: '" + __fileName + "' can not be mapped in memory!");
+	}
+	__map = static_cast<char*> (map);
+	__capacity = capacity;
+}
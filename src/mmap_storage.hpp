@@ -0,0 +1,80 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OPENDB_MMAP_STORAGE_HEADER__
+#define __OPENDB_MMAP_STORAGE_HEADER__
+
+#include "file_storage.hpp"
+
+namespace openDB{
+/* La classe mmap_storage memorizza i record su file esattamente come file_storage, di cui riutilizza l'indice dei record e la gestione del cestino, ma accede
+ * al file attraverso una sua proiezione in memoria (mmap) anziché attraverso chiamate di sistema di lettura e scrittura. I record vengono letti direttamente
+ * dalla memoria proiettata.
+ * La proiezione viene estesa a blocchi di dimensione chunk man mano che i record vengono accodati: il file viene allungato fino alla nuova capacità e la
+ * proiezione viene rifatta. Alla distruzione dell'oggetto il file viene riportato alla dimensione effettivamente occupata dai record.
+ * È indicata per tabelle lette molto più spesso di quanto vengano modificate.
+ */
+class mmap_storage : public file_storage {
+public:
+		/* Il costruttore crea il file fileName, troncandolo se esiste già, e ne proietta in memoria i primi chunk byte.
+		 * Se reattach è true, il file viene riutilizzato esattamente come avviene per file_storage (vedi file_storage.hpp) e la proiezione viene dimensionata
+		 * in modo da contenere i record già presenti.
+		 * Viene generata una eccezione di tipo file_creation se non è possibile creare il file o proiettarlo in memoria, di tipo file_open se il file è già in
+		 * uso da parte di un altro processo.
+		 */
+		mmap_storage(std::string fileName, std::streamoff chunk = default_chunk, bool reattach = false) throw (storage_exception&);
+		virtual ~mmap_storage();
+
+		/* La funzione clear svuota il gestore, liberando lo spazio occupato dai record e riportando il gestore allo stato in cui si troverebbe se fosse stato appena
+		 * creato.
+		 */
+		virtual void clear () throw ();
+
+		/* Le funzioni begin_bulk ed end_bulk non attivano il buffer di file_storage: i record vengono già accodati copiandoli nella memoria proiettata, senza chiamate
+		 * di sistema. Viene soltanto dimensionato l'indice.
+		 */
+		virtual void begin_bulk (unsigned long records = 0) throw ()
+				{reserve(records);}
+		virtual void end_bulk () throw (storage_exception&) {}
+
+		static const std::streamoff default_chunk = 16777216;		/*	dimensione di default dei blocchi con cui viene estesa la proiezione: 16 MiB	*/
+
+protected:
+		/* Le funzioni write, append e read sostituiscono le omologhe di file_storage copiando i record da e verso la memoria proiettata. La lettura di più record
+		 * non usa io_uring: i record vengono letti uno alla volta dalla memoria proiettata.
+		 * La funzione append estende la proiezione, se necessario, prima di accodare il record. La funzione window restituisce direttamente l'indirizzo dei byte
+		 * all'interno della memoria proiettata, senza copiarli.
+		 */
+		virtual void write (const record& _record, const segment _segment) const throw (storage_exception&);
+		virtual void append (const record& _record, segment& _segment) throw (storage_exception&);
+		virtual void read (record& _record, const segment _segment) const throw (storage_exception&);
+		virtual void read (std::vector<record>& records, const std::vector<segment>& segments) const throw (storage_exception&);
+		virtual const char* window (std::streamoff begin, std::streamoff end, std::string& buffer) const throw (storage_exception&);
+
+		/* La funzione move sposta i record all'interno della memoria proiettata. La funzione truncate riduce il file e la proiezione al più piccolo multiplo di
+		 * chunk in grado di contenere i record.
+		 */
+		virtual void move (std::streamoff from, std::streamoff to, std::streamoff byte) throw (storage_exception&);
+		virtual void truncate () throw (storage_exception&);
+
+private:
+		char*			__map;			/*	indirizzo della proiezione in memoria del file	*/
+		std::streamoff	__capacity;		/*	dimensione della proiezione, e del file, in byte	*/
+		std::streamoff	__chunk;		/*	granularità con cui viene estesa la proiezione	*/
+
+		/* La funzione remap porta la dimensione del file e della proiezione al più piccolo multiplo di __chunk non inferiore a byte. Viene generata una eccezione di
+		 * tipo io_error se non è possibile estendere il file o proiettarlo in memoria.
+		 */
+		void remap (std::streamoff byte) throw (storage_exception&);
+};
+}; /*	end of openDB namespace	*/
+#endif
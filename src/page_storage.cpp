@@ -0,0 +1,402 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "page_storage.hpp"
+#include "common.hpp"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/file.h>
+#include <cstring>
+#include <algorithm>
+using namespace openDB;
+
+/* La prima pagina del file contiene, nell'ordine: l'identificativo header_magic, la versione del formato, un flag che indica se il file è stato chiuso
+ * correttamente, la dimensione delle pagine, l'ultima chiave generata e l'epoch. Come per file_storage, i valori sono memorizzati nella rappresentazione
+ * della macchina.
+ */
+static const char header_magic[8] = {'o', 'D', 'B', 'p', 'a', 'g', 'e', 's'};
+static const unsigned header_version = 1;
+
+template <typename T> static void put (std::string& buffer, const T& value) {
+	buffer.append(reinterpret_cast<const char*> (&value), sizeof(T));
+}
+
+template <typename T> static bool get (const char*& buffer, const char* end, T& value) {
+	if (end - buffer < (std::ptrdiff_t) sizeof(T))
+		return false;
+	std::memcpy(&value, buffer, sizeof(T));
+	buffer += sizeof(T);
+	return true;
+}
+
+static bool aligned (std::size_t pageSize) {
+	return pageSize != 0 && pageSize % buffer_pool::alignment == 0;
+}
+
+page_storage::page_storage(std::string fileName, std::size_t pageSize, std::size_t budget, bool reattach) throw (storage_exception&) : storage(), __fileName(fileName),
+	__pageSize(pageSize), __fd(aligned(pageSize) ? open(fileName.c_str(), (reattach ? O_RDWR|O_CREAT : O_RDWR|O_CREAT|O_TRUNC), S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH) : -1),
+	__persistent(reattach), __pool(__fd, pageSize, budget) {
+	if (!aligned(pageSize))
+		throw storage_exception("Error: the page size of '" + __fileName + "' must be a multiple of " + std::to_string(buffer_pool::alignment) + " bytes!");
+	if(__fd < 0)
+		throw file_creation("Error: '" + __fileName + "' can not be created!");
+	if (reattach) {
+		if (flock(__fd, LOCK_EX|LOCK_NB) != 0) {
+			close(__fd);
+			__fd = -1;
+			throw file_open("Error: '" + __fileName + "' is in use by another process!");
+		}
+		if (load())
+			return;
+	}
+	clear();
+}
+
+page_storage::~page_storage() {
+	if (__fd >= 0) {
+		if (__persistent) {
+			try {
+				__pool.flush();
+				store_header(true);
+			}
+			catch (storage_exception&) {}	//le pagine modificate non sono state scritte: il file non verrà riutilizzato
+		}
+		close(__fd);
+	}
+}
+
+std::unique_ptr<std::list<unsigned long>> page_storage::internalID () const throw () {
+	std::unique_ptr<std::list<unsigned long>> ptr(new std::list<unsigned long>);
+	for (std::unordered_map <unsigned long, location>::const_iterator it = __recordMap.begin(); it != __recordMap.end(); it++)
+		ptr -> push_back(it -> first);
+	return ptr;
+}
+
+void page_storage::clear () throw () {
+	__pool.discard();
+	__recordMap.clear();
+	__pages.assign(1, page_info());
+	__bySpace.clear();
+	__pending.clear();
+	if (ftruncate(__fd, 0) != 0) {}		//le pagine vengono comunque riscritte a partire dalla prima
+	__lastKey = 0;
+	__epoch.clear();
+	store_header(false);
+}
+
+unsigned long page_storage::insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) {
+	std::string buffer;
+	record::write(buffer, valuesMap, columnsMap, _state);
+	return add(buffer, _state);
+}
+
+unsigned long page_storage::insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) {
+	unsigned long first = __lastKey;
+	std::string buffer;
+	for (std::size_t row = 0; row < _batch.rows(); row++) {
+		buffer.clear();
+		record::write(buffer, _batch, row, _state);
+		add(buffer, _state);
+	}
+	return first;
+}
+
+unsigned long page_storage::add (const std::string& buffer, enum record::state _state) throw (storage_exception&) {
+	location _location;
+	_location.state = _state;
+	_location.visible = (_state != record::deleting);
+	store(__lastKey, buffer, _location, 0);
+	__recordMap.insert(std::pair<unsigned long, location>(__lastKey, _location));
+	track(__lastKey, _state);
+	return __lastKey++;
+}
+
+void page_storage::update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) {
+	std::unique_ptr<record> record_ptr = get_record(ID);
+	record_ptr -> update(valuesMap, columnsMap);
+	rewrite(ID, *record_ptr);
+}
+
+void page_storage::cancel (unsigned long ID) throw (storage_exception&) {
+	std::unique_ptr<record> record_ptr = get_record(ID);
+	record_ptr -> cancel();
+	rewrite(ID, *record_ptr);
+}
+
+void page_storage::erase (unsigned long ID) throw (storage_exception&) {
+	std::unordered_map<unsigned long, location>::iterator record_it = __recordMap.find(ID);
+	if (record_it == __recordMap.end())
+		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
+	unsigned long page = record_it->second.page;
+	remove(page, record_it->second.slot);
+	__recordMap.erase(record_it);
+	untrack(ID);
+	reclaim(page);
+}
+
+const page_storage::location& page_storage::get_location (unsigned long ID) const throw (storage_exception&) {
+	std::unordered_map<unsigned long, location>::const_iterator record_it = __recordMap.find(ID);
+	if (record_it != __recordMap.end())
+		return record_it->second;
+	else
+		throw record_not_exists("There is no record with " + std::to_string(ID) + " id.");
+}
+
+std::unique_ptr<record> page_storage::get_record (unsigned long ID) const throw (storage_exception&) {
+	const location& _location = get_location(ID);
+	const char* data = __pool.get(_location.page, __pages[_location.page].span);
+	const slot& _slot = reinterpret_cast<const slot*>(data + sizeof(page_header))[_location.slot];
+	if (_slot.ID != ID)
+		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	std::unique_ptr<record> ptr(new record);
+	ptr->read(data + _slot.offset, _slot.size);
+	return ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> page_storage::current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&) {
+	const location& _location = get_location(ID);
+	const char* data = __pool.get(_location.page, __pages[_location.page].span);
+	const slot& _slot = reinterpret_cast<const slot*>(data + sizeof(page_header))[_location.slot];
+	if (_slot.ID != ID)
+		throw io_error("I/O error during read: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	return record::project(data + _slot.offset, _slot.size, columns);
+}
+
+void page_storage::scan (visitor& _visitor) const throw (basic_exception&) {
+	std::string buffer;
+	record _record;
+	for (unsigned long page = 1; page < __pages.size(); page++) {
+		unsigned span = __pages[page].span;
+		if (span == 0)
+			continue;
+		buffer.assign(__pool.get(page, span), __pageSize * span);		//visit potrebbe leggere altre pagine, rendendo non valido l'indirizzo restituito da get
+		const slot* slots = reinterpret_cast<const slot*>(buffer.data() + sizeof(page_header));
+		for (unsigned i = 0; i < reinterpret_cast<const page_header*>(buffer.data())->slots; i++)
+			if (slots[i].size > 0) {
+				_record.read(buffer.data() + slots[i].offset, slots[i].size);
+				_visitor.visit(slots[i].ID, _record);
+			}
+	}
+}
+
+void page_storage::rewrite (unsigned long ID, const record& _record) throw (storage_exception&) {
+	std::string buffer;
+	_record.write(buffer);
+	location& _location = __recordMap.find(ID)->second;
+	unsigned long page = _location.page;
+	remove(page, _location.slot);
+	store(ID, buffer, _location, page);
+	_location.state = _record.state();
+	_location.visible = _record.visible();
+	track(ID, _location.state);
+	if (_location.page != page)
+		reclaim(page);
+}
+
+void page_storage::store (unsigned long ID, const std::string& buffer, location& _location, unsigned long preferred) throw (storage_exception&) {
+	unsigned long page = ((preferred != 0 && __pages[preferred].free >= buffer.size() + sizeof(slot)) ? preferred : allocate(buffer.size()));
+	_location.slot = place(page, ID, buffer);
+	_location.page = page;
+}
+
+unsigned long page_storage::allocate (std::size_t byte) throw (storage_exception&) {
+	std::set<std::pair<unsigned, unsigned long>>::const_iterator it = __bySpace.lower_bound(std::pair<unsigned, unsigned long>(byte + sizeof(slot), 0));
+	if (it != __bySpace.end())
+		return it->second;
+	unsigned long page = __pages.size();
+	unsigned span = (sizeof(page_header) + sizeof(slot) + byte + __pageSize - 1) / __pageSize;
+	__pages.resize(page + span, page_info());
+	format(page, span);
+	return page;
+}
+
+unsigned page_storage::place (unsigned long page, unsigned long ID, const std::string& buffer) throw (storage_exception&) {
+	char* data = __pool.get(page, __pages[page].span);
+	page_header* header = reinterpret_cast<page_header*>(data);
+	slot* slots = reinterpret_cast<slot*>(data + sizeof(page_header));
+	unsigned index = 0;
+	while (index < header->slots && slots[index].size != 0)
+		index++;
+	std::size_t needed = buffer.size() + (index == header->slots ? sizeof(slot) : 0);
+	if (needed > header->free)
+		throw io_error("I/O error during write: '" + __fileName + "' may be corrupt or there may be a bug in the program!");
+	if (sizeof(page_header) + header->slots * sizeof(slot) + needed > header->upper) {
+		//lo spazio libero è frammentato: i record vengono compattati verso la fine della pagina, dal più vicino alla fine, senza modificare gli slot
+		std::vector<std::pair<unsigned, unsigned>> order;
+		for (unsigned i = 0; i < header->slots; i++)
+			if (slots[i].size != 0)
+				order.push_back(std::pair<unsigned, unsigned>(slots[i].offset, i));
+		std::sort(order.rbegin(), order.rend());
+		unsigned upper = header->span * __pageSize;
+		for (std::vector<std::pair<unsigned, unsigned>>::const_iterator it = order.begin(); it != order.end(); it++) {
+			slot& _slot = slots[it->second];
+			upper -= _slot.size;
+			if (upper != _slot.offset)
+				std::memmove(data + upper, data + _slot.offset, _slot.size);
+			_slot.offset = upper;
+		}
+		header->upper = upper;
+	}
+	if (index == header->slots)
+		header->slots++;
+	header->upper -= buffer.size();
+	std::memcpy(data + header->upper, buffer.data(), buffer.size());
+	slots[index].ID = ID;
+	slots[index].offset = header->upper;
+	slots[index].size = buffer.size();
+	header->free -= needed;
+	__pool.dirty(page);
+	space(page, header->free);
+	return index;
+}
+
+void page_storage::remove (unsigned long page, unsigned index) throw (storage_exception&) {
+	char* data = __pool.get(page, __pages[page].span);
+	page_header* header = reinterpret_cast<page_header*>(data);
+	slot* slots = reinterpret_cast<slot*>(data + sizeof(page_header));
+	if (slots[index].offset == header->upper)
+		header->upper += slots[index].size;
+	header->free += slots[index].size;
+	slots[index].size = 0;
+	while (header->slots > 0 && slots[header->slots - 1].size == 0) {
+		header->slots--;
+		header->free += sizeof(slot);
+	}
+	if (header->slots == 0)
+		header->upper = header->span * __pageSize;
+	__pool.dirty(page);
+	space(page, header->free);
+}
+
+void page_storage::reclaim (unsigned long page) throw (storage_exception&) {
+	unsigned span = __pages[page].span;
+	if (span < 2 || reinterpret_cast<const page_header*>(__pool.get(page, span))->slots != 0)
+		return;
+	__pool.drop(page);
+	for (unsigned i = 0; i < span; i++)
+		format(page + i, 1);
+}
+
+void page_storage::space (unsigned long page, unsigned free) throw () {
+	page_info& info = __pages[page];
+	if (info.span == 1)
+		__bySpace.erase(std::pair<unsigned, unsigned long>(info.free, page));
+	info.free = free;
+	if (info.span == 1 && free > sizeof(slot))
+		__bySpace.insert(std::pair<unsigned, unsigned long>(free, page));
+}
+
+void page_storage::format (unsigned long page, unsigned span) throw (storage_exception&) {
+	page_header* header = reinterpret_cast<page_header*>(__pool.get(page, span, true));
+	header->span = span;
+	header->slots = 0;
+	header->upper = span * __pageSize;
+	header->free = header->upper - sizeof(page_header);
+	__pages[page].span = span;
+	space(page, header->free);
+}
+
+bool page_storage::load () throw () {
+	off_t fileSize = lseek(__fd, 0, SEEK_END);
+	if (fileSize < (off_t) __pageSize || fileSize % __pageSize != 0)
+		return false;
+	unsigned long count = fileSize / __pageSize;
+	std::unordered_map<unsigned long, location> recordMap;
+	std::vector<page_info> pages(count, page_info());
+	unsigned long lastKey = 0;
+	std::string epoch;
+	bool valid = false;
+	try {
+		const char* it = __pool.get(0, 1);
+		const char* end = it + __pageSize;
+		unsigned version = 0, clean = 0;
+		std::size_t pageSize = 0;
+		valid = (std::memcmp(it, header_magic, sizeof(header_magic)) == 0);
+		it += sizeof(header_magic);
+		valid = valid && get(it, end, version) && get(it, end, clean) && get(it, end, pageSize) && get(it, end, lastKey) && openDB::read(it, end, epoch);
+		valid = valid && version == header_version && clean == 1 && pageSize == __pageSize;
+
+		for (unsigned long page = 1; valid && page < count; ) {
+			const char* data = __pool.get(page, 1);
+			page_header header = *reinterpret_cast<const page_header*>(data);
+			if (header.span == 0 || header.span > count - page) {
+				valid = false;
+				break;
+			}
+			if (header.span > 1)
+				data = __pool.get(page, header.span);
+			std::size_t unit = header.span * __pageSize;
+			std::size_t used = sizeof(page_header) + header.slots * sizeof(slot);
+			valid = (used <= header.upper && header.upper <= unit);
+			const slot* slots = reinterpret_cast<const slot*>(data + sizeof(page_header));
+			for (unsigned i = 0; valid && i < header.slots; i++) {
+				if (slots[i].size == 0)
+					continue;
+				location _location;
+				if (slots[i].offset < header.upper || slots[i].size > unit - slots[i].offset || slots[i].ID >= lastKey || !record::peek(data + slots[i].offset, slots[i].size, _location.state, _location.visible)) {
+					valid = false;
+					break;
+				}
+				_location.page = page;
+				_location.slot = i;
+				valid = recordMap.insert(std::pair<unsigned long, location>(slots[i].ID, _location)).second;
+				used += slots[i].size;
+			}
+			valid = valid && header.free == unit - used;
+			pages[page].span = header.span;
+			pages[page].free = header.free;
+			page += header.span;
+		}
+	}
+	catch (storage_exception&) {
+		valid = false;
+	}
+	if (!valid) {		//il file non è stato chiuso correttamente o non è valido
+		__pool.discard();
+		return false;
+	}
+
+	__recordMap.swap(recordMap);
+	__pages.swap(pages);
+	__bySpace.clear();
+	for (unsigned long page = 1; page < __pages.size(); page++)
+		if (__pages[page].span == 1 && __pages[page].free > sizeof(slot))
+			__bySpace.insert(std::pair<unsigned, unsigned long>(__pages[page].free, page));
+	__lastKey = lastKey;
+	__epoch = epoch;
+	if (!store_header(false)) {
+		__recordMap.clear();
+		__pool.discard();
+		return false;
+	}
+	__pending.clear();
+	for (std::unordered_map<unsigned long, location>::const_iterator record_it = __recordMap.begin(); record_it != __recordMap.end(); record_it++)
+		track(record_it->first, record_it->second.state);
+	return true;
+}
+
+bool page_storage::store_header (bool clean) throw () {
+	std::string buffer(header_magic, sizeof(header_magic));
+	put(buffer, header_version);
+	put(buffer, (unsigned) (clean ? 1 : 0));
+	put(buffer, __pageSize);
+	put(buffer, __lastKey);
+	openDB::write(buffer, (buffer.size() + sizeof(unsigned) + __epoch.size() <= __pageSize ? __epoch : std::string()));		//un epoch troppo lungo viene scartato: il contenuto verrà ricaricato
+	try {
+		std::memcpy(__pool.get(0, 1, true), buffer.data(), buffer.size());
+		__pool.flush();
+	}
+	catch (storage_exception&) {
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,214 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_PAGE_STORAGE_HEADER__
+#define __OPENDB_PAGE_STORAGE_HEADER__
+
+#include "storage.hpp"
+#include "buffer_pool.hpp"
+#include <vector>
+#include <set>
+
+namespace openDB{
+/* La classe page_storage memorizza i record su file, come file_storage, ma organizza il file in pagine di dimensione fissa anziché in una sequenza di record
+ * di dimensione variabile. Le pagine vengono lette e scritte attraverso un buffer_pool (vedi buffer_pool.hpp), che mantiene in memoria le pagine usate più di
+ * recente entro un limite di memoria stabilito: i record letti spesso vengono serviti senza alcuna operazione di I/O, gli altri vengono letti una pagina alla
+ * volta, con letture allineate, e le modifiche vengono scritte sul file solo quando una pagina viene rimossa dalla memoria.
+ *
+ * Ogni pagina contiene una intestazione, un vettore di slot, che cresce dall'inizio della pagina verso la fine, e i record, che vengono scritti a partire
+ * dalla fine della pagina verso l'inizio; lo spazio libero si trova tra gli slot e i record. Ogni slot contiene la chiave del record, la sua posizione
+ * all'interno della pagina e la sua dimensione; uno slot di dimensione nulla è libero e può essere riutilizzato.
+ * Un record viene individuato dalla pagina e dallo slot che lo contengono: se viene modificato e non trova più spazio nella propria pagina viene spostato in
+ * un'altra, aggiornando l'indice, senza che la sua chiave cambi. Lo spazio rilasciato all'interno di una pagina viene recuperato compattandone i record, senza
+ * modificare gli slot, quando serve per inserirne uno nuovo.
+ * Un record più grande di una pagina occupa da solo un blocco di pagine consecutive, gestito come se fosse un'unica pagina. Quando il record viene rimosso le
+ * pagine del blocco tornano ad essere disponibili singolarmente.
+ * La prima pagina del file contiene la dimensione delle pagine, l'ultima chiave generata e l'epoch (vedi storage::epoch).
+ */
+class page_storage : public storage {
+public:
+		/* Il costruttore crea il file fileName, troncandolo se esiste già, con pagine di pageSize byte e un buffer_pool che occupa al più budget byte.
+		 * La dimensione delle pagine deve essere un multiplo di buffer_pool::alignment, altrimenti viene generata una eccezione di tipo storage_exception.
+		 * Se non è possibile creare il file viene generata una eccezione di tipo file_creation.
+		 *
+		 * Se il parametro reattach è true il file non viene troncato: se è stato chiuso correttamente da un precedente oggetto page_storage, con la stessa
+		 * dimensione delle pagine, i record che contiene tornano ad essere gestiti, con le stesse chiavi e lo stesso epoch, e l'indice viene ricostruito
+		 * leggendo gli slot delle pagine; altrimenti il file viene troncato. Il file viene marcato come aperto subito dopo essere stato letto, e come chiuso
+		 * correttamente solo dal distruttore, dopo aver scritto tutte le pagine modificate, per cui un file lasciato da un processo terminato in modo anomalo non
+		 * viene mai riutilizzato.
+		 * Il file viene bloccato (flock) per tutta la vita dell'oggetto: se è già in uso da parte di un altro processo viene generata una eccezione di tipo
+		 * file_open.
+		 */
+		page_storage(std::string fileName, std::size_t pageSize = default_page_size, std::size_t budget = default_budget, bool reattach = false) throw (storage_exception&);
+		virtual ~page_storage();
+
+		page_storage(const page_storage&) = delete;
+		page_storage& operator= (const page_storage&) = delete;
+
+		/* Vedi storage.hpp.
+		 */
+		virtual std::unique_ptr<std::list<unsigned long>> internalID () const throw ();
+		virtual unsigned long numRecords () const throw ()
+				{return __recordMap.size();}
+		virtual void clear () throw ();
+
+		/* La funzione insert serializza il record (vedi record::write) e lo scrive nella pagina con meno spazio libero in grado di contenerlo, oppure in una
+		 * nuova pagina in coda al file. Può generare le stesse eccezioni di file_storage::insert.
+		 */
+		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&);
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&);
+
+		/* Le funzioni update e cancel riscrivono il record nella stessa pagina, se c'è spazio sufficiente, altrimenti lo spostano in un'altra pagina. La funzione
+		 * erase libera lo slot occupato dal record. Possono generare le stesse eccezioni delle omologhe di file_storage.
+		 */
+		virtual void update (unsigned long ID, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&);
+		virtual void cancel (unsigned long ID) throw (storage_exception&);
+		virtual void erase (unsigned long ID) throw (storage_exception&);
+
+		/* Le funzioni state e visible leggono lo stato e la visibilità del record dall'indice, senza accedere alle pagine.
+		 */
+		virtual enum record::state state (unsigned long ID) const throw (storage_exception&)
+				{return get_location(ID).state;}
+		virtual bool visible (unsigned long ID)	const throw (storage_exception&)
+				{return get_location(ID).visible;}
+
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&)
+				{return get_record(ID)->current();}
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&)
+				{return get_record(ID)->old();}
+
+		/* La seconda versione della funzione current decodifica i valori richiesti direttamente dalla pagina (vedi record::project).
+		 */
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&);
+
+		/* La funzione scan visita i record pagina per pagina, dalla prima all'ultima, per cui il file viene letto sequenzialmente e ciascuna pagina una sola
+		 * volta. Vedi storage.hpp.
+		 */
+		virtual void scan (visitor& _visitor) const throw (basic_exception&);
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&)
+				{_visitor.visit(ID, *get_record(ID));}
+		virtual std::unique_ptr<cursor> rows () const throw ()
+				{return std::unique_ptr<cursor>(new key_cursor<std::unordered_map<unsigned long, location>::const_iterator>(*this, __recordMap.begin(), __recordMap.end()));}
+
+		/* La funzione begin_bulk dimensiona l'indice: i record vengono comunque accumulati nelle pagine in memoria e scritti una pagina alla volta.
+		 */
+		virtual void begin_bulk (unsigned long records = 0) throw ()
+				{__recordMap.reserve(__recordMap.size() + records);}
+
+		virtual std::string epoch () const throw ()
+				{return __epoch;}
+		virtual void epoch (std::string _epoch) throw ()
+				{__epoch = _epoch;}
+
+		/* La funzione flush scrive sul file tutte le pagine modificate. Viene generata una eccezione di tipo io_error in caso di errore.
+		 */
+		void flush () throw (storage_exception&)
+				{__pool.flush();}
+
+		/* La funzione budget modifica la memoria massima occupata dalle pagine. La funzione pool_statistics restituisce i contatori del buffer_pool.
+		 */
+		void budget (std::size_t _budget) throw ()
+				{__pool.budget(_budget);}
+		buffer_pool::statistics pool_statistics () const throw ()
+				{return __pool.stats();}
+
+		static const std::size_t default_page_size = 8192;			/*	8 KiB	*/
+		static const std::size_t default_budget = 67108864;			/*	64 MiB	*/
+
+private:
+		/* Intestazione di una pagina, o di un blocco di span pagine: numero di slot, offset rispetto all'inizio della pagina del primo byte occupato dai
+		 * record e numero di byte liberi.
+		 */
+		struct page_header {
+				unsigned	span;
+				unsigned	slots;
+				unsigned	upper;
+				unsigned	free;
+		};
+		struct slot {
+				unsigned long	ID;
+				unsigned		offset;
+				unsigned		size;
+		};
+
+		/* Per ciascun record l'indice contiene la pagina e lo slot che lo contengono, oltre ad una copia dello stato e della visibilità, come avviene per
+		 * file_storage.
+		 */
+		struct location {
+				location() : page(0), slot(0), state(record::empty), visible(false) {}
+				unsigned long		page;
+				unsigned			slot;
+				enum record::state	state;
+				bool				visible;
+		};
+
+		/* Per ciascuna pagina del file viene mantenuto il numero di pagine del blocco che inizia con essa (zero per le pagine interne ad un blocco e per la prima
+		 * pagina del file) e il numero di byte liberi. Le pagine singole con spazio libero sono indicizzate per spazio libero in __bySpace, in modo che un record
+		 * venga inserito nella pagina con meno spazio libero in grado di contenerlo (best-fit).
+		 */
+		struct page_info {
+				unsigned	span;
+				unsigned	free;
+		};
+
+		std::string										__fileName;
+		std::size_t										__pageSize;
+		int												__fd;
+		bool											__persistent;
+		mutable buffer_pool								__pool;
+		std::unordered_map<unsigned long, location>		__recordMap;
+		std::vector<page_info>							__pages;
+		std::set<std::pair<unsigned, unsigned long>>	__bySpace;
+		std::string										__epoch;
+
+		const location& get_location (unsigned long ID) const throw (storage_exception&);
+		std::unique_ptr<record> get_record (unsigned long ID) const throw (storage_exception&);
+
+		/* La funzione store scrive il record serializzato in buffer nella pagina preferred, se c'è spazio sufficiente, altrimenti in quella scelta da allocate,
+		 * e ne restituisce la posizione in _location. La funzione allocate restituisce la pagina singola con meno spazio libero in grado di contenere byte byte,
+		 * oppure aggiunge in coda al file una nuova pagina o, se byte non entra in una pagina, un nuovo blocco.
+		 */
+		void store (unsigned long ID, const std::string& buffer, location& _location, unsigned long preferred) throw (storage_exception&);
+
+		/* La funzione add memorizza, con una nuova chiave, il record serializzato in buffer, nello stato _state, e ne restituisce la chiave.
+		 */
+		unsigned long add (const std::string& buffer, enum record::state _state) throw (storage_exception&);
+
+		/* La funzione rewrite sostituisce il record con chiave ID con _record, usata da update e cancel.
+		 */
+		void rewrite (unsigned long ID, const record& _record) throw (storage_exception&);
+		unsigned long allocate (std::size_t byte) throw (storage_exception&);
+
+		/* La funzione place scrive il record nella pagina page, che deve contenere spazio sufficiente, compattando i record della pagina se necessario, e
+		 * restituisce lo slot utilizzato. La funzione remove libera lo slot slot della pagina page. La funzione reclaim rende nuovamente disponibili
+		 * singolarmente le pagine di un blocco che non contiene più alcun record.
+		 */
+		unsigned place (unsigned long page, unsigned long ID, const std::string& buffer) throw (storage_exception&);
+		void remove (unsigned long page, unsigned slot) throw (storage_exception&);
+		void reclaim (unsigned long page) throw (storage_exception&);
+
+		/* La funzione space aggiorna lo spazio libero della pagina page, mantenendo coerente __bySpace.
+		 */
+		void space (unsigned long page, unsigned free) throw ();
+
+		/* La funzione format inizializza, in memoria, una pagina o un blocco vuoto di span pagine a partire dalla pagina page.
+		 */
+		void format (unsigned long page, unsigned span) throw (storage_exception&);
+
+		/* La funzione load ricostruisce l'indice e lo spazio libero delle pagine leggendo il file. Restituisce false, senza modificare l'oggetto, se il file non è
+		 * stato chiuso correttamente o non è valido. La funzione store_header scrive la prima pagina del file; clean indica se il file è stato chiuso
+		 * correttamente e restituisce false se la scrittura non va a buon fine.
+		 */
+		bool load () throw ();
+		bool store_header (bool clean) throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
@@ -10,31 +10,200 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include "record.hpp"
+#include "dictionary.hpp"
 #include "common.hpp"
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <mutex>
 using namespace openDB;
 
-record::record (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state) throw (basic_exception&) {
+/* Tutti i descrittori creati sono contenuti nel registro, indicizzati per descrittore di base (0 per i descrittori di base) e nomi delle colonne; i
+ * descrittori di base sono indicizzati anche per impronta e, in columns, per somma degli hash dei nomi delle colonne, che non dipende dal loro ordine e
+ * consente di trovare il descrittore di una tabella senza ordinarne le colonne. Le dichiarazioni (vedi descriptor::declare) non appartengono al registro,
+ * che ne conserva soltanto un riferimento debole.
+ */
+struct registry {
+	std::mutex mutex;
+	std::map<std::pair<const record::descriptor*, std::vector<std::string>>, std::unique_ptr<record::descriptor>> descriptors;
+	std::unordered_map<unsigned long long, const record::descriptor*> fingerprints;
+	std::unordered_multimap<std::size_t, const record::descriptor*> columns;
+	std::list<std::weak_ptr<const record::descriptor>> declared;
+};
+
+static std::size_t columns_hash (const std::unordered_map<std::string, column>& columnsMap) {
+	std::size_t hash = 0;
+	for (std::unordered_map<std::string, column>::const_iterator it = columnsMap.begin(); it != columnsMap.end(); it++)
+		hash += std::hash<std::string>()(it->first);
+	return hash;
+}
+
+static registry& get_registry () {
+	static registry _registry;
+	return _registry;
+}
+
+record::descriptor::descriptor (const std::vector<std::string>& names, const descriptor* base) throw () : __names(names), __base(base ? base : this), __positions(names.size()), __fingerprint(14695981039346656037ULL) {
+	for (std::size_t i = 0; i < __names.size(); i++)
+		if (!__base->ordinal(__names[i], __positions[i]))
+			__positions[i] = i;
+	for (std::size_t i = 0; i < __names.size() && !base; i++)
+		for (std::size_t j = 0; j <= __names[i].size(); j++) {		//FNV-1a dei nomi, compreso il terminatore di ciascuno
+			__fingerprint ^= (unsigned char) __names[i].c_str()[j];
+			__fingerprint *= 1099511628211ULL;
+		}
+}
+
+const record::descriptor* record::descriptor::get (const std::vector<std::string>& names) throw () {
+	return get(names, 0);
+}
+
+const record::descriptor* record::descriptor::get (const std::vector<std::string>& names, const descriptor* base) throw () {
+	registry& _registry = get_registry();
+	std::lock_guard<std::mutex> lock(_registry.mutex);
+	std::unique_ptr<descriptor>& _descriptor = _registry.descriptors[std::pair<const descriptor*, std::vector<std::string>>(base, names)];
+	if (!_descriptor) {
+		_descriptor.reset(new descriptor(names, base));
+		if (!base)
+			_registry.fingerprints.insert(std::pair<unsigned long long, const descriptor*>(_descriptor->__fingerprint, _descriptor.get()));
+	}
+	return _descriptor.get();
+}
+
+const record::descriptor* record::descriptor::get (const std::unordered_map<std::string, column>& columnsMap) throw () {
+	registry& _registry = get_registry();
+	std::size_t hash = columns_hash(columnsMap);
+	{
+		std::lock_guard<std::mutex> lock(_registry.mutex);
+		typedef std::unordered_multimap<std::size_t, const descriptor*>::const_iterator iterator;
+		std::pair<iterator, iterator> candidates = _registry.columns.equal_range(hash);
+		for (iterator it = candidates.first; it != candidates.second; it++) {
+			bool same = (it->second->size() == columnsMap.size());
+			std::size_t ordinal;
+			for (std::unordered_map<std::string, column>::const_iterator column_it = columnsMap.begin(); same && column_it != columnsMap.end(); column_it++)
+				same = it->second->ordinal(column_it->first, ordinal);
+			if (same)
+				return it->second;
+		}
+	}
+	std::vector<std::string> names;
+	names.reserve(columnsMap.size());
+	for (std::unordered_map<std::string, column>::const_iterator it = columnsMap.begin(); it != columnsMap.end(); it++)
+		names.push_back(it->first);
+	std::sort(names.begin(), names.end());
+	const descriptor* _descriptor = get(names, 0);
+	std::lock_guard<std::mutex> lock(_registry.mutex);
+	_registry.columns.insert(std::pair<std::size_t, const descriptor*>(hash, _descriptor));
+	return _descriptor;
+}
+
+std::shared_ptr<const record::descriptor> record::descriptor::declare (const std::unordered_map<std::string, column>& columnsMap) throw () {
+	std::vector<std::string> names;
+	names.reserve(columnsMap.size());
+	for (std::unordered_map<std::string, column>::const_iterator it = columnsMap.begin(); it != columnsMap.end(); it++)
+		names.push_back(it->first);
+	std::sort(names.begin(), names.end());
+	std::shared_ptr<const descriptor> _descriptor(new descriptor(names, 0));
+	registry& _registry = get_registry();
+	std::lock_guard<std::mutex> lock(_registry.mutex);
+	for (std::list<std::weak_ptr<const descriptor>>::iterator it = _registry.declared.begin(); it != _registry.declared.end(); )
+		if (it->expired())
+			it = _registry.declared.erase(it);
+		else
+			it++;
+	_registry.declared.push_back(_descriptor);
+	return _descriptor;
+}
+
+const record::descriptor* record::descriptor::find (unsigned long long fingerprint) throw () {
+	registry& _registry = get_registry();
+	std::shared_ptr<const descriptor> declared;
+	{
+		std::lock_guard<std::mutex> lock(_registry.mutex);
+		std::unordered_map<unsigned long long, const descriptor*>::const_iterator it = _registry.fingerprints.find(fingerprint);
+		if (it != _registry.fingerprints.end())
+			return it->second;
+		for (std::list<std::weak_ptr<const descriptor>>::const_iterator declared_it = _registry.declared.begin(); !declared && declared_it != _registry.declared.end(); declared_it++) {
+			std::shared_ptr<const descriptor> candidate = declared_it->lock();
+			if (candidate && candidate->__fingerprint == fingerprint)
+				declared = candidate;
+		}
+	}
+	return (declared ? get(declared->__names, 0) : 0);		//il descrittore registrato sostituisce la dichiarazione
+}
+
+bool record::descriptor::ordinal (const std::string& name, std::size_t& _ordinal) const throw () {
+	std::vector<std::string>::const_iterator it = std::lower_bound(__names.begin(), __names.end(), name);
+	if (it == __names.end() || *it != name)
+		return false;
+	_ordinal = it - __names.begin();
+	return true;
+}
+
+record::record (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state, arena* _arena, dictionary* _dictionary) throw (basic_exception&) : __current(arena_allocator<cell>(_arena)), __old(arena_allocator<cell>(_arena)) {
 	validate_column_name(valuesMap, columnsMap);
 	if (_state != loaded)
 		validate_columns_value(valuesMap, columnsMap);
-	build_value_map(valuesMap, columnsMap);
+	build_value_map(valuesMap, columnsMap, _dictionary);
 	__state = _state;
 	(__state != deleting ? __visible = true : __visible = false);
 }
 
-void record::update (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) {
+record::batch::batch (const std::vector<std::string>& columns, const std::vector<std::vector<std::string>>& values, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&) : __rows(values.empty() ? 0 : values.front().size()) {
+	if (values.size() != columns.size())
+		throw invalid_argument("The batch must contain one vector of values for each column.");
+	for (std::size_t i = 0; i < values.size(); i++)
+		if (values[i].size() != __rows)
+			throw invalid_argument("The vectors of values of the batch must have the same size.");
+	const descriptor* base = descriptor::get(columnsMap);
+	std::vector<const std::vector<std::string>*> sources(base->size(), 0);
+	for (std::size_t i = 0; i < columns.size(); i++) {
+		std::size_t position;
+		if (!base->ordinal(columns[i], position))
+			throw column_not_exists("'" + columns[i] + "' column doesn't exists.");
+		if (sources[position])
+			throw invalid_argument("'" + columns[i] + "' column appears more than once.");
+		sources[position] = &values[i];
+	}
+	std::vector<std::string> names;
+	__bitmap.assign((base->size() + 7) / 8, '\0');
+	for (std::size_t position = 0; position < base->size(); position++) {
+		const column& _column = columnsMap.find(base->name(position))->second;
+		if (sources[position]) {
+			names.push_back(base->name(position));
+			__values.push_back(sources[position]);
+			__columns.push_back(&_column);
+			__bitmap[position / 8] |= (char) (1 << (position % 8));
+		}
+		else
+			if (_column.is_key())
+				throw empty_key("Value for a key-column can not be null or empty!");
+	}
+	__descriptor = (names.size() == base->size() ? base : descriptor::get(names, base));
+}
+
+record::record (const batch& _batch, std::size_t row, enum state _state, arena* _arena, dictionary* _dictionary) throw (data_exception&) : __state(_state), __descriptor(_batch.__descriptor), __current(_batch.__columns.size(), cell(), arena_allocator<cell>(_arena)), __old(arena_allocator<cell>(_arena)), __visible(_state != deleting) {
+	for (std::size_t i = 0; i < __current.size(); i++) {
+		const std::string& value = (*_batch.__values[i])[row];
+		if (_state != loaded)
+			assign_value(__current[i], __descriptor->name(i), _batch.__columns[i]->validate_value(value), *_batch.__columns[i], _arena, _dictionary);
+		else
+			assign_value(__current[i], __descriptor->name(i), value, *_batch.__columns[i], _arena, _dictionary);
+	}
+}
+
+void record::update (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw (basic_exception&) {
 	validate_column_name(valuesMap, columnsMap);
 	validate_columns_value(valuesMap, columnsMap);
 	switch (__state) {
 		case empty :
 		case inserting :
-			__valueMap.clear();
-			build_value_map(valuesMap, columnsMap);
+			build_value_map(valuesMap, columnsMap, _dictionary);
 			__state = inserting;
 			break;
 		case loaded :
 		case updating :
-			update_value_map(valuesMap, columnsMap);
+			update_value_map(valuesMap, columnsMap, _dictionary);
 			__state = updating;
 			break;
 		case deleting :
@@ -44,55 +213,327 @@ void record::update (std::unordered_map<std::string, std::string>& valuesMap, st
 
 std::unique_ptr<std::unordered_map<std::string, std::string>> record::current() const throw () {
 	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
-	for (std::unordered_map<std::string, value>::const_iterator it = __valueMap.begin(); it != __valueMap.end(); it++)
-		map_ptr->insert(std::pair<std::string, std::string>(it->first, it->second.current));
+	for (std::size_t i = 0; i < __current.size(); i++)
+		map_ptr->insert(std::pair<std::string, std::string>(__descriptor->name(i), __current[i].text()));
 	return map_ptr;
 }
 
 std::unique_ptr<std::unordered_map<std::string, std::string>> record::old() const throw () {
 	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
-	for (std::unordered_map<std::string, value>::const_iterator it = __valueMap.begin(); it != __valueMap.end(); it++)
-		map_ptr->insert(std::pair<std::string, std::string>(it->first, it->second.old));
+	for (std::size_t i = 0; i < __current.size(); i++)
+		map_ptr->insert(std::pair<std::string, std::string>(__descriptor->name(i), (__old.empty() ? std::string() : __old[i].text())));
+	return map_ptr;
+}
+
+std::unique_ptr<std::unordered_map<std::string, std::string>> record::current(const std::list<std::string>& columns) const throw () {
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+	std::size_t ordinal;
+	for (std::list<std::string>::const_iterator it = columns.begin(); it != columns.end() && __descriptor; it++)
+		if (__descriptor->ordinal(*it, ordinal))
+			map_ptr->insert(std::pair<std::string, std::string>(*it, __current[ordinal].text()));
 	return map_ptr;
 }
 
+/* Una tupla viene memorizzata nel formato seguente:
+ * 	- un byte che identifica il formato, record_format;
+ * 	- un byte che contiene lo stato (tre bit meno significativi), la visibilità e la presenza di valori precedenti non vuoti;
+ * 	- l'impronta del descrittore di base (vedi record::descriptor);
+ * 	- un vettore di bit, uno per ciascuna colonna del descrittore di base, che indica quali colonne sono presenti nella tupla;
+ * 	- se la tupla contiene valori precedenti non vuoti, un vettore di bit che indica quali colonne hanno un valore precedente non vuoto;
+ * 	- per ciascuna colonna presente, nell'ordine del descrittore di base, il valore corrente e, se presente, il valore precedente, ciascuno serializzato
+ * 	  come una cella (vedi cell::write): la lunghezza (varint), che indica anche se il valore è in forma nativa, ed il valore.
+ * Le tuple scritte in formato plain_format hanno la stessa struttura, ma i valori sono sempre stringhe e la loro lunghezza non contiene l'indicazione della
+ * forma nativa. Il formato utilizzato dalle versioni ancora precedenti inizia con lo stato, memorizzato come enum state, per cui il primo byte vale al più
+ * deleting e non può essere confuso con i precedenti. I valori sono memorizzati nella rappresentazione della macchina.
+ */
+static const unsigned char record_format = 0x82;
+static const unsigned char plain_format = 0x81;
+static const unsigned char state_mask = 0x07;
+static const unsigned char visible_flag = 0x08;
+static const unsigned char old_flag = 0x10;
+
+static std::size_t header_size (std::size_t columns, bool old) {
+	return 2 + sizeof(unsigned long long) + (old ? 2 : 1) * ((columns + 7) / 8);
+}
+
+bool record::resolve (const handle& _handle) const throw () {
+	if (_handle.__descriptor != __descriptor) {
+		_handle.__descriptor = __descriptor;
+		_handle.__present = (__descriptor && __descriptor->ordinal(_handle.__name, _handle.__ordinal));
+	}
+	return _handle.__present;
+}
+
+bool record::current (const handle& _handle, field& _field) const throw () {
+	if (!resolve(_handle))
+		return false;
+	__current[_handle.__ordinal].view(_field);
+	return true;
+}
+
+bool record::old (const handle& _handle, field& _field) const throw () {
+	if (!resolve(_handle))
+		return false;
+	old(_handle.__ordinal, _field);
+	return true;
+}
+
 std::streamoff record::size() const throw () {
-	unsigned long size = 3 * sizeof(unsigned) * __valueMap.size() + sizeof(unsigned) + sizeof(bool) + sizeof(enum state);
-	for (std::unordered_map<std::string, value>::const_iterator it = __valueMap.begin(); it != __valueMap.end(); it++)
-		size += it->first.size() + it->second.current.size() + it->second.old.size();
-	return (std::streamoff) size;
+	const descriptor* _descriptor = (__descriptor ? __descriptor : descriptor::get(std::vector<std::string>()));
+	bool old = false;
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < __current.size(); i++) {
+		size += __current[i].size();
+		if (!__old.empty() && !__old[i].empty()) {
+			size += __old[i].size();
+			old = true;
+		}
+	}
+	return (std::streamoff) (size + header_size(_descriptor->base()->size(), old));
+}
+
+std::size_t record::footprint () const throw () {
+	std::size_t bytes = sizeof(record) + (__current.capacity() + __old.capacity()) * sizeof(cell);
+	for (std::size_t i = 0; i < __current.size(); i++)
+		bytes += __current[i].heap();
+	for (std::size_t i = 0; i < __old.size(); i++)
+		bytes += __old[i].heap();
+	return bytes;
+}
+
+void record::write (std::string& buffer) const throw () {
+	const descriptor* _descriptor = (__descriptor ? __descriptor : descriptor::get(std::vector<std::string>()));
+	std::size_t columns = _descriptor->base()->size();
+	std::size_t bitmap = (columns + 7) / 8;
+	bool old = false;
+	for (std::size_t i = 0; i < __old.size() && !old; i++)
+		old = !__old[i].empty();
+	buffer.push_back((char) record_format);
+	buffer.push_back((char) ((__state & state_mask) | (__visible ? visible_flag : 0) | (old ? old_flag : 0)));
+	unsigned long long fingerprint = _descriptor->fingerprint();
+	buffer.append(reinterpret_cast<const char*> (&fingerprint), sizeof(unsigned long long));
+	std::size_t present = buffer.size();
+	buffer.append((old ? 2 : 1) * bitmap, '\0');
+	for (std::size_t i = 0; i < __current.size(); i++) {
+		std::size_t position = _descriptor->position(i);
+		buffer[present + position / 8] |= (char) (1 << (position % 8));
+		__current[i].write(buffer);
+		if (old && !__old[i].empty()) {
+			buffer[present + bitmap + position / 8] |= (char) (1 << (position % 8));
+			__old[i].write(buffer);
+		}
+	}
 }
 
-void record::write (std::fstream& stream) const	throw (storage_exception&) {
-	stream.write(reinterpret_cast<const char*> (&__state), sizeof(enum state));
-	stream.write(reinterpret_cast<const char*> (&__visible), sizeof(bool));
-	unsigned num_of_elements = __valueMap.size();
-	stream.write(reinterpret_cast <const char*> (&num_of_elements), sizeof (unsigned));
-	for (std::unordered_map<std::string, value>::const_iterator it = __valueMap.begin(); it != __valueMap.end(); it++) {
-		openDB::write(stream, it->first);
-		openDB::write(stream, it->second.current);
-		openDB::write(stream, it->second.old);
+bool record::peek (const char* buffer, std::streamoff size, enum state& _state, bool& _visible) throw () {
+	if (size >= 2 && ((unsigned char) *buffer == record_format || (unsigned char) *buffer == plain_format)) {
+		_state = (enum state) (buffer[1] & state_mask);
+		_visible = (buffer[1] & visible_flag);
+		return true;
 	}
+	if (size < (std::streamoff)(sizeof(enum state) + sizeof(bool)))
+		return false;
+	std::memcpy(&_state, buffer, sizeof(enum state));
+	std::memcpy(&_visible, buffer + sizeof(enum state), sizeof(bool));
+	return true;
 }
 
-void record::read (std::fstream& stream) throw (storage_exception&) {
-	__valueMap.clear();
-	stream.read(reinterpret_cast<char*> (&__state), sizeof(enum state));
-	stream.read(reinterpret_cast<char*> (&__visible), sizeof(bool));
+std::unique_ptr<std::unordered_map<std::string, std::string>> record::project (const char* buffer, std::streamoff size, const std::list<std::string>& columns) throw (storage_exception&) {
+	const char* end = buffer + size;
+	if (size < 1 || ((unsigned char) *buffer != record_format && (unsigned char) *buffer != plain_format)) {
+		record _record;
+		_record.read_legacy(buffer, end);
+		return _record.current(columns);
+	}
+	if (size < (std::streamoff) header_size(0, false))
+		throw io_error("I/O error: the record is truncated.");
+	bool tagged = ((unsigned char) *buffer == record_format);
+	unsigned char flags = buffer[1];
+	unsigned long long fingerprint;
+	std::memcpy(&fingerprint, buffer + 2, sizeof(unsigned long long));
+	buffer += 2 + sizeof(unsigned long long);
+	const descriptor* base = descriptor::find(fingerprint);
+	if (!base)
+		throw io_error("I/O error: the record belongs to a table with different columns.");
+	std::size_t bitmap = (base->size() + 7) / 8;
+	bool old = (flags & old_flag);
+	if ((std::size_t) (end - buffer) < (old ? 2 : 1) * bitmap)
+		throw io_error("I/O error: the record is truncated.");
+	const unsigned char* present = reinterpret_cast<const unsigned char*> (buffer);
+	const unsigned char* old_present = present + bitmap;
+	buffer += (old ? 2 : 1) * bitmap;
+
+	std::vector<bool> requested(base->size(), false);
+	std::size_t last = 0, count = 0;
+	for (std::list<std::string>::const_iterator it = columns.begin(); it != columns.end(); it++) {
+		std::size_t position;
+		if (base->ordinal(*it, position) && (present[position / 8] & (1 << (position % 8))) && !requested[position]) {
+			requested[position] = true;
+			last = std::max(last, position);
+			count++;
+		}
+	}
+	std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>(count));
+	for (std::size_t position = 0; count > 0 && position <= last; position++) {
+		if (!(present[position / 8] & (1 << (position % 8))))
+			continue;
+		if (requested[position]) {
+			std::string& value = (*map_ptr)[base->name(position)];
+			if (!cell::read(buffer, end, tagged, value))
+				throw io_error("I/O error: the record is truncated.");
+		}
+		else if (!cell::skip(buffer, end, tagged))
+			throw io_error("I/O error: the record is truncated.");
+		if (old && (old_present[position / 8] & (1 << (position % 8))) && !cell::skip(buffer, end, tagged))
+			throw io_error("I/O error: the record is truncated.");
+	}
+	return map_ptr;
+}
+
+static bool same_columns (const record::descriptor* _descriptor, const record::descriptor* base, const std::vector<std::size_t>& positions) {
+	if (!_descriptor || _descriptor->base() != base || _descriptor->size() != positions.size())
+		return false;
+	for (std::size_t i = 0; i < positions.size(); i++)
+		if (_descriptor->position(i) != positions[i])
+			return false;
+	return true;
+}
+
+void record::read (const char* buffer, std::streamoff size) throw (storage_exception&) {
+	const char* end = buffer + size;
+	if (size < 1 || ((unsigned char) *buffer != record_format && (unsigned char) *buffer != plain_format)) {
+		read_legacy(buffer, end);
+		return;
+	}
+	if (size < (std::streamoff) header_size(0, false))
+		throw io_error("I/O error: the record is truncated.");
+	bool tagged = ((unsigned char) *buffer == record_format);
+	unsigned char flags = buffer[1];
+	unsigned long long fingerprint;
+	std::memcpy(&fingerprint, buffer + 2, sizeof(unsigned long long));
+	buffer += 2 + sizeof(unsigned long long);
+	const descriptor* base = descriptor::find(fingerprint);
+	if (!base)
+		throw io_error("I/O error: the record belongs to a table with different columns.");
+	std::size_t bitmap = (base->size() + 7) / 8;
+	bool old = (flags & old_flag);
+	if ((std::size_t) (end - buffer) < (old ? 2 : 1) * bitmap)
+		throw io_error("I/O error: the record is truncated.");
+	const unsigned char* present = reinterpret_cast<const unsigned char*> (buffer);
+	const unsigned char* old_present = present + bitmap;
+	buffer += (old ? 2 : 1) * bitmap;
+
+	std::vector<std::size_t> positions;
+	positions.reserve(base->size());
+	for (std::size_t position = 0; position < base->size(); position++)
+		if (present[position / 8] & (1 << (position % 8)))
+			positions.push_back(position);
+	__state = (enum state) (flags & state_mask);
+	__visible = (flags & visible_flag);
+	__current.resize(positions.size());
+	__old.clear();
+	if (old)
+		__old.resize(positions.size());
+	for (std::size_t i = 0; i < positions.size(); i++) {
+		if (!__current[i].read(buffer, end, tagged))
+			throw io_error("I/O error: the record is truncated.");
+		if (old && (old_present[positions[i] / 8] & (1 << (positions[i] % 8))) && !__old[i].read(buffer, end, tagged))
+			throw io_error("I/O error: the record is truncated.");
+	}
+	if (buffer != end)
+		throw io_error("I/O error: the record is corrupt.");
+	if (positions.size() == base->size())
+		__descriptor = base;
+	else if (!same_columns(__descriptor, base, positions)) {
+		std::vector<std::string> names(positions.size());
+		for (std::size_t i = 0; i < positions.size(); i++)
+			names[i] = base->name(positions[i]);
+		__descriptor = descriptor::get(names, base);
+	}
+}
+
+void record::read_legacy (const char* buffer, const char* end) throw (storage_exception&) {
+	if (end - buffer < (std::ptrdiff_t)(sizeof(enum state) + sizeof(bool) + sizeof(unsigned)))
+		throw io_error("I/O error: the record is truncated.");
+	std::memcpy(&__state, buffer, sizeof(enum state));
+	buffer += sizeof(enum state);
+	std::memcpy(&__visible, buffer, sizeof(bool));
+	buffer += sizeof(bool);
 	unsigned num_of_elements = 0;
-	stream.read(reinterpret_cast <char*> (&num_of_elements), sizeof (unsigned));
+	std::memcpy(&num_of_elements, buffer, sizeof(unsigned));
+	buffer += sizeof(unsigned);
+	if (num_of_elements > (std::size_t)(end - buffer) / (3 * sizeof(unsigned)))
+		throw io_error("I/O error: the record is truncated.");
+	std::vector<std::string> names(num_of_elements), current(num_of_elements), old(num_of_elements);
+	bool updated = false;
 	for (unsigned i = 0; i < num_of_elements; i++) {
-		std::string first;
-		openDB::read(stream, first);
-		std::string current;
-		openDB::read(stream, current);
-		std::string old;
-		openDB::read(stream, old);
-		__valueMap.insert(std::pair<std::string, value>(first, value(current, old)));
+		if (!openDB::read(buffer, end, names[i]) || !openDB::read(buffer, end, current[i]) || !openDB::read(buffer, end, old[i]))
+			throw io_error("I/O error: the record is truncated.");
+		updated = updated || !old[i].empty();
+	}
+	if (buffer != end)
+		throw io_error("I/O error: the record is corrupt.");
+	if (!std::is_sorted(names.begin(), names.end())) {		//tupla scritta in un ordine diverso da quello del descrittore
+		std::map<std::string, std::pair<std::string, std::string>> sorted;
+		for (unsigned i = 0; i < num_of_elements; i++)
+			sorted[names[i]] = std::pair<std::string, std::string>(current[i], old[i]);
+		std::map<std::string, std::pair<std::string, std::string>>::iterator it = sorted.begin();
+		for (unsigned i = 0; it != sorted.end(); i++, it++) {
+			names[i] = it->first;
+			current[i].swap(it->second.first);
+			old[i].swap(it->second.second);
+		}
 	}
+	__current.resize(num_of_elements);
+	__old.clear();
+	if (updated)
+		__old.resize(num_of_elements);
+	for (unsigned i = 0; i < num_of_elements; i++) {
+		__current[i].assign(current[i]);
+		if (updated)
+			__old[i].assign(old[i]);
+	}
+	if (!__descriptor || __descriptor->names() != names)
+		__descriptor = descriptor::get(names);
 }
 
-void record::validate_column_name(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) const throw (column_not_exists&) {
+void record::write (std::string& buffer, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state) throw (basic_exception&) {
+	validate_column_name(valuesMap, columnsMap);
+	if (_state != loaded)
+		validate_columns_value(valuesMap, columnsMap);
+	std::vector<std::unordered_map<std::string, std::string>::const_iterator> present;
+	const descriptor* base = present_columns(valuesMap, columnsMap, present);
+	buffer.push_back((char) record_format);
+	buffer.push_back((char) ((_state & state_mask) | (_state != deleting ? visible_flag : 0)));
+	unsigned long long fingerprint = base->fingerprint();
+	buffer.append(reinterpret_cast<const char*> (&fingerprint), sizeof(unsigned long long));
+	std::size_t bitmap = buffer.size();
+	buffer.append((base->size() + 7) / 8, '\0');
+	for (std::size_t i = 0; i < present.size(); i++) {
+		std::size_t position;
+		base->ordinal(present[i]->first, position);
+		buffer[bitmap + position / 8] |= (char) (1 << (position % 8));
+		cell::write(buffer, present[i]->second, columnsMap.find(present[i]->first)->second.native());
+	}
+}
+
+void record::write (std::string& buffer, const batch& _batch, std::size_t row, enum state _state) throw (data_exception&) {
+	std::vector<std::string> validated;
+	if (_state != loaded) {		//i valori vengono validati prima di modificare il buffer
+		validated.reserve(_batch.__columns.size());
+		for (std::size_t i = 0; i < _batch.__columns.size(); i++)
+			validated.push_back(_batch.__columns[i]->validate_value((*_batch.__values[i])[row]));
+	}
+	buffer.push_back((char) record_format);
+	buffer.push_back((char) ((_state & state_mask) | (_state != deleting ? visible_flag : 0)));
+	unsigned long long fingerprint = _batch.__descriptor->fingerprint();
+	buffer.append(reinterpret_cast<const char*> (&fingerprint), sizeof(unsigned long long));
+	buffer.append(_batch.__bitmap);
+	for (std::size_t i = 0; i < _batch.__columns.size(); i++)
+		cell::write(buffer, (_state != loaded ? validated[i] : (*_batch.__values[i])[row]), _batch.__columns[i]->native());
+}
+
+void record::validate_column_name(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (column_not_exists&) {
 	for (std::unordered_map<std::string, std::string>::const_iterator valueMap_it = valueMap.begin(); valueMap_it != valueMap.end(); valueMap_it++)
 		if (columnsMap.find(valueMap_it->first) == columnsMap.end())
 			throw column_not_exists("'" + valueMap_it->first + "' column doesn't exists.");
@@ -106,23 +547,102 @@ void record::validate_columns_value(std::unordered_map<std::string, std::string>
 	}
 }
 
-void record::build_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (empty_key&) {
-	for (std::unordered_map<std::string, column>::const_iterator columnsMap_it = columnsMap.begin(); columnsMap_it != columnsMap.end(); columnsMap_it++) {
-		std::unordered_map<std::string, std::string>::const_iterator valueMap_it = valueMap.find(columnsMap_it->first);
+const record::descriptor* record::present_columns(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, std::vector<std::unordered_map<std::string, std::string>::const_iterator>& present) throw (empty_key&) {
+	const descriptor* base = descriptor::get(columnsMap);
+	present.reserve(base->size());
+	for (std::size_t i = 0; i < base->size(); i++) {
+		std::unordered_map<std::string, std::string>::const_iterator valueMap_it = valueMap.find(base->name(i));
 		if (valueMap_it!=valueMap.end())
-			__valueMap.insert(std::pair<std::string, value>(valueMap_it->first, value(valueMap_it->second, "")));
+			present.push_back(valueMap_it);
 		else
-			if (columnsMap_it->second.is_key())
+			if (columnsMap.find(base->name(i))->second.is_key())
 				throw empty_key("Value for a key-column can not be null or empty!");
 	}
+	return base;
 }
 
-void record::update_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw () {
+void record::assign_value(cell& _cell, const std::string& name, const std::string& value, const column& _column, arena* _arena, dictionary* _dictionary) throw () {
+	const std::string* shared = 0;
+	if (_dictionary && _column.native() == sqlType::as_text && value.size() > cell::local_size)
+		shared = _dictionary->intern(name, value);
+	if (shared)
+		_cell.share(*shared);
+	else
+		_cell.assign(value, _column.native(), _arena);
+}
+
+void record::build_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw (empty_key&) {
+	std::vector<std::unordered_map<std::string, std::string>::const_iterator> present;
+	const descriptor* base = present_columns(valueMap, columnsMap, present);
+	arena* _arena = __current.get_allocator().get_arena();
+	cell_vector values(present.size(), cell(), __current.get_allocator());
+	for (std::size_t i = 0; i < present.size(); i++)
+		assign_value(values[i], present[i]->first, present[i]->second, columnsMap.find(present[i]->first)->second, _arena, _dictionary);
+	if (present.size() == base->size())
+		__descriptor = base;
+	else {
+		std::vector<std::string> names(present.size());
+		for (std::size_t i = 0; i < present.size(); i++)
+			names[i] = present[i]->first;
+		__descriptor = descriptor::get(names, base);
+	}
+	__current.swap(values);
+	cell_vector(__old.get_allocator()).swap(__old);
+}
+
+void record::update_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw () {
+	std::vector<std::string> added;
 	for (std::unordered_map<std::string, column>::const_iterator columnsMap_it = columnsMap.begin(); columnsMap_it != columnsMap.end(); columnsMap_it++) {
 		std::unordered_map<std::string, std::string>::const_iterator valueMap_it = valueMap.find(columnsMap_it->first);
-		if (valueMap_it!=valueMap.end() && !columnsMap_it->second.is_key()) {
-			__valueMap.find(valueMap_it->first)->second.old = __valueMap.find(valueMap_it->first)->second.current;
-			__valueMap.find(valueMap_it->first)->second.current = valueMap_it->second;
+		std::size_t i;
+		if (valueMap_it == valueMap.end() || columnsMap_it->second.is_key())
+			continue;
+		if (__descriptor && __descriptor->ordinal(valueMap_it->first, i)) {
+			if (__old.empty())
+				__old.resize(__current.size());
+			__old[i] = std::move(__current[i]);
+			assign_value(__current[i], valueMap_it->first, valueMap_it->second, columnsMap_it->second, __current.get_allocator().get_arena(), _dictionary);
 		}
+		else
+			added.push_back(valueMap_it->first);
+	}
+	if (!added.empty())
+		add_columns(added, valueMap, columnsMap, _dictionary);
+}
+
+static bool describes (const record::descriptor* base, const std::vector<std::string>& names) {
+	std::size_t ordinal;
+	for (std::size_t i = 0; i < names.size(); i++)
+		if (!base->ordinal(names[i], ordinal))
+			return false;
+	return true;
+}
+
+void record::add_columns(const std::vector<std::string>& added, std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw () {
+	std::vector<std::string> names(added);
+	if (__descriptor)
+		names.insert(names.end(), __descriptor->names().begin(), __descriptor->names().end());
+	std::sort(names.begin(), names.end());
+	// il descrittore di base della tupla potrebbe non contenere le nuove colonne, se queste sono state aggiunte alla tabella dopo la creazione della tupla
+	const descriptor* base = (__descriptor ? __descriptor->base() : descriptor::get(columnsMap));
+	if (!describes(base, names))
+		base = descriptor::get(columnsMap);
+	if (!describes(base, names))
+		base = descriptor::get(names);
+	arena* _arena = __current.get_allocator().get_arena();
+	cell_vector current(names.size(), cell(), __current.get_allocator());
+	cell_vector old(names.size(), cell(), __old.get_allocator());
+	for (std::size_t i = 0; i < names.size(); i++) {
+		std::size_t ordinal;
+		if (__descriptor && __descriptor->ordinal(names[i], ordinal)) {
+			current[i] = std::move(__current[ordinal]);
+			if (!__old.empty())
+				old[i] = std::move(__old[ordinal]);
+		}
+		else
+			assign_value(current[i], names[i], valueMap.find(names[i])->second, columnsMap.find(names[i])->second, _arena, _dictionary);
 	}
+	__descriptor = (names.size() == base->size() ? base : descriptor::get(names, base));
+	__current.swap(current);
+	__old.swap(old);
 }
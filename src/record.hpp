@@ -17,10 +17,17 @@
 #include <unordered_map>
 #include <memory>
 #include <fstream>
+#include <vector>
+#include <list>
 #include "column.hpp"
+#include "cell.hpp"
+#include "arena.hpp"
 #include "exception.hpp"
 
 namespace openDB{
+class dictionary;
+class column_storage;
+
 /*
  */
 class record {
@@ -35,6 +42,60 @@ public:
 	 */
 	enum state {empty, loaded, inserting, updating, deleting};
 
+	/* La classe descriptor descrive le colonne di cui una tupla contiene i valori. I nomi delle colonne, in ordine alfabetico, vengono memorizzati una sola
+	 * volta e condivisi da tutte le tuple che contengono le stesse colonne; ciascuna tupla memorizza soltanto i valori, in un vettore indicizzato dalla
+	 * posizione (ordinale) della colonna nel descrittore.
+	 * Il descrittore di base di una tupla descrive tutte le colonne della tabella a cui appartiene; se la tupla non contiene il valore di tutte le colonne, il
+	 * suo descrittore descrive soltanto quelle presenti e fa riferimento al descrittore di base. Il descrittore di base è identificato da una impronta (hash
+	 * FNV-1a dei nomi delle colonne), che viene memorizzata su file al posto dei nomi delle colonne (vedi record::write).
+	 * I descrittori vengono creati esclusivamente dalle funzioni get, che restituiscono sempre lo stesso oggetto per lo stesso insieme di colonne, e non
+	 * vengono mai distrutti: il loro numero è limitato dal numero di insiemi di colonne distinti utilizzati dal programma.
+	 */
+	class descriptor {
+	public:
+		/* La prima versione della funzione get restituisce il descrittore di base delle colonne names, che devono essere ordinate alfabeticamente e distinte.
+		 * La seconda restituisce il descrittore delle colonne names, che devono essere un sottoinsieme di quelle descritte da base. La terza restituisce il
+		 * descrittore di base delle colonne di una tabella.
+		 * La funzione declare rende note le colonne di una tabella prima che ne venga creata una tupla, in modo che find possa riconoscere l'impronta delle
+		 * tuple lette da file (vedi table::add_column): il descrittore restituito non viene registrato, e la dichiarazione decade quando tutte le copie del
+		 * puntatore vengono distrutte. La funzione find restituisce il descrittore di base con impronta fingerprint, se è stato creato o se corrisponde alle
+		 * colonne di una dichiarazione ancora valida, altrimenti 0.
+		 */
+		static const descriptor* get (const std::vector<std::string>& names) throw ();
+		static const descriptor* get (const std::vector<std::string>& names, const descriptor* base) throw ();
+		static const descriptor* get (const std::unordered_map<std::string, column>& columnsMap) throw ();
+		static std::shared_ptr<const descriptor> declare (const std::unordered_map<std::string, column>& columnsMap) throw ();
+		static const descriptor* find (unsigned long long fingerprint) throw ();
+
+		std::size_t size () const throw ()
+				{return __names.size();}
+		const std::string& name (std::size_t ordinal) const throw ()
+				{return __names[ordinal];}
+		const std::vector<std::string>& names () const throw ()
+				{return __names;}
+
+		/* La funzione ordinal restituisce, in _ordinal, la posizione della colonna name; restituisce false se la colonna non è descritta dal descrittore.
+		 */
+		bool ordinal (const std::string& name, std::size_t& _ordinal) const throw ();
+
+		/* La funzione base restituisce il descrittore di base, che coincide con il descrittore stesso se questo è di base. La funzione position restituisce la
+		 * posizione nel descrittore di base della colonna in posizione ordinal.
+		 */
+		const descriptor* base () const throw ()
+				{return __base;}
+		std::size_t position (std::size_t ordinal) const throw ()
+				{return __positions[ordinal];}
+		unsigned long long fingerprint () const throw ()
+				{return __base->__fingerprint;}
+
+	private:
+		descriptor (const std::vector<std::string>& names, const descriptor* base) throw ();
+		std::vector<std::string>	__names;
+		const descriptor*			__base;
+		std::vector<std::size_t>	__positions;
+		unsigned long long			__fingerprint;
+	};
+
 	/* Costruttore
 	 * Il costruttore senza argomenti costruisce una tupla vuota, utile nel caso in cui si debba leggere tuple da file;
 	 * Il costruttore con argomenti consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
@@ -49,9 +110,12 @@ public:
 	 * - column_not_exists : se una delle corrispondenze colonna-valore in valuesMap non è valida, cioè la colonna non esiste in columnsMap;
 	 * - data_exception : viene generata una eccezione di tipo derivato da data_exception (vedi header 'exception.hpp') quando la corrispondenza colonna-valore non è
 	 * 					  valida a causa di un errore dovuto ad un valore non compatibile con il tipo della colonna.
+	 * Se il parametro _arena non è nullo, i valori della tupla vengono allocati nell'arena (vedi arena.hpp), che deve sopravvivere alla tupla; le copie della
+	 * tupla, invece, allocano i propri valori singolarmente. Allo stesso modo, se il parametro _dictionary non è nullo, i valori delle colonne testuali
+	 * vengono condivisi, quando possibile, con il dizionario (vedi dictionary.hpp), che deve sopravvivere alla tupla.
 	 */
-	record () throw () : __state(empty), __visible(false) {}
-	record (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state) throw (basic_exception&);
+	record () throw () : __state(empty), __descriptor(0), __visible(false) {}
+	record (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state, arena* _arena = 0, dictionary* _dictionary = 0) throw (basic_exception&);
 
 	/* La funzione update consente di marcare i valori di una tupla affinchè siano aggiornati correttamente. Prende i seguenti parametri:
 	 * consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
@@ -60,12 +124,14 @@ public:
 	 * 				 non fosse valido per il tipo di colonna al quale deve corrispondere, viene generata una eccezione derivata da data_exception. Vedi l'header
 	 * 				 sqlType.hpp per i dettagli.
 	 * 	- columnsMap : mappa delle colonne che compongono una tabella. Questo parametro viene utilizzato per la validazione dei valori contenuti in valueMap.
+	 * 	Le colonne di valueMap che la tupla non contiene vengono aggiunte alla tupla, con il valore precedente vuoto.
 	 * 	Quando si aggiorna un oggetto record possono essere generate le seguenti tipologie di eccezione:
 	 * - column_not_exists : se una delle corrispondenze colonna-valore in valuesMap non è valida, cioè la colonna non esiste in columnsMap;
 	 * - data_exception : viene generata una eccezione di tipo derivato da data_exception (vedi header 'exception.hpp') quando la corrispondenza colonna-valore non è
 	 * 					  valida a causa di un errore dovuto ad un valore non compatibile con il tipo della colonna.
+	 * Il parametro _dictionary ha lo stesso significato che ha nel costruttore.
 	 */
-	void update (std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&);
+	void update (std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary = 0) throw (basic_exception&);
 
 	/* La funzione cancel marca una tupla affinchè sia rimossa dal database remoto all'atto del commit. */
 	void cancel () throw ()
@@ -87,31 +153,147 @@ public:
 	std::unique_ptr<std::unordered_map<std::string, std::string>> current() const throw ();
 	std::unique_ptr<std::unordered_map<std::string, std::string>> old() const throw ();
 
+	/* La seconda versione della funzione current restituisce soltanto i valori correnti delle colonne columns; le colonne che la tupla non contiene vengono
+	 * ignorate.
+	 */
+	std::unique_ptr<std::unordered_map<std::string, std::string>> current(const std::list<std::string>& columns) const throw ();
+
+	/* Le funzioni seguenti consentono di leggere i valori della tupla senza allocare memoria, attraverso oggetti field (vedi cell.hpp), che restano validi
+	 * finché la tupla non viene modificata o distrutta. Sono pensate per l'uso all'interno di un oggetto storage::visitor (vedi storage.hpp).
+	 * 	- fields restituisce il numero di valori contenuti nella tupla; name restituisce il nome della colonna del valore in posizione ordinal, in ordine
+	 * 	  alfabetico;
+	 * 	- current ed old leggono, in _field, il valore corrente e quello precedente in posizione ordinal; il valore precedente di una tupla mai aggiornata
+	 * 	  è una stringa vuota;
+	 * 	- get_descriptor restituisce il descrittore della tupla, condiviso da tutte le tuple che contengono le stesse colonne.
+	 */
+	std::size_t fields () const throw ()
+		{return __current.size();}
+	const std::string& name (std::size_t ordinal) const throw ()
+		{return __descriptor->name(ordinal);}
+	void current (std::size_t ordinal, field& _field) const throw ()
+		{__current[ordinal].view(_field);}
+	void old (std::size_t ordinal, field& _field) const throw ()
+		{if (__old.empty()) _field = field(); else __old[ordinal].view(_field);}
+	const descriptor* get_descriptor () const throw ()
+		{return __descriptor;}
+
+	/* Un oggetto handle identifica una colonna per nome e memorizza la posizione del suo valore all'interno dell'ultima tupla letta attraverso di esso,
+	 * in modo che la ricerca per nome venga ripetuta solo quando la tupla ha un descrittore diverso. Le funzioni current ed old che accettano un oggetto
+	 * handle leggono il valore della colonna corrispondente; restituiscono false, lasciando _field invariato, se la tupla non contiene la colonna.
+	 */
+	class handle {
+	public:
+		explicit handle (const std::string& name) throw () : __name(name), __descriptor(0), __ordinal(0), __present(false) {}
+		const std::string& name () const throw ()
+				{return __name;}
+	private:
+		friend class record;
+		std::string					__name;
+		mutable const descriptor*	__descriptor;
+		mutable std::size_t			__ordinal;
+		mutable bool				__present;
+	};
+	bool current (const handle& _handle, field& _field) const throw ();
+	bool old (const handle& _handle, field& _field) const throw ();
+
+	/* Un oggetto batch descrive un insieme di tuple che contengono le stesse colonne, da inserire con una sola operazione (vedi storage::insert e
+	 * table::load). I valori sono organizzati per colonna: values[i][j] è il valore della colonna columns[i] nella tupla j, per cui tutti i vettori di values
+	 * devono avere la stessa lunghezza, pari al numero di tuple. Il costruttore risolve, una volta per tutte le tuple, la corrispondenza tra le colonne, il
+	 * loro tipo e la loro posizione nel descrittore, e può generare le seguenti eccezioni:
+	 * - column_not_exists : se una delle colonne non esiste in columnsMap;
+	 * - empty_key : se una colonna chiave, o che compone la chiave, non è tra quelle di columns;
+	 * - invalid_argument : se una colonna compare più di una volta o se values non contiene un vettore di lunghezza uniforme per ciascuna colonna.
+	 * L'oggetto fa riferimento a values ed alle colonne di columnsMap, che devono sopravvivergli. La costante default_rows è il numero di tuple per batch
+	 * consigliato a chi suddivide un caricamento in più batch.
+	 */
+	class batch {
+	public:
+		static const std::size_t default_rows = 1024;
+
+		batch (const std::vector<std::string>& columns, const std::vector<std::vector<std::string>>& values, std::unordered_map<std::string, column>& columnsMap) throw (basic_exception&);
+		std::size_t rows () const throw ()
+				{return __rows;}
+	private:
+		friend class record;
+		friend class column_storage;
+		const descriptor*								__descriptor;
+		std::vector<const std::vector<std::string>*>	__values;		//per ciascuna colonna del descrittore, i suoi valori
+		std::vector<const column*>						__columns;
+		std::string										__bitmap;		//colonne presenti, nel formato di record::write
+		std::size_t										__rows;
+	};
+
+	/* Il costruttore che accetta un oggetto batch costruisce la tupla row del batch, esattamente come se i suoi valori fossero passati al costruttore
+	 * precedente. Poichè le colonne sono già state verificate dal batch, può generare soltanto eccezioni derivate da data_exception, se _state non è loaded
+	 * ed uno dei valori non è valido.
+	 * La funzione statica write che accetta un oggetto batch è l'analoga della funzione write descritta più avanti.
+	 */
+	record (const batch& _batch, std::size_t row, enum state _state, arena* _arena = 0, dictionary* _dictionary = 0) throw (data_exception&);
+	static void write (std::string& buffer, const batch& _batch, std::size_t row, enum state _state) throw (data_exception&);
+
 
 	/* La funzione size restituisce il numero di byte necessari alla memorizzazione su file della tupla.
-	 * La funzione write consente la scrittura della tupla su stream binario. Viene generata una eccezione di tipo storage_exception nel caso in cui la scrittura non
-	 * fosse possibile.
-	 * La funzione read consente la lettura della tupla su stream binario. Viene generata una eccezione di tipo storage_exception nel caso in cui la lettura non
-	 * fosse possibile.
+	 * La funzione write serializza la tupla, accodandola al buffer binario passato come parametro. Il buffer può poi essere scritto su file con una singola
+	 * operazione di I/O.
+	 * La funzione read ricostruisce la tupla a partire dai size byte puntati da buffer. Viene generata una eccezione di tipo io_error, derivata da storage_exception,
+	 * nel caso in cui i size byte non contengano esattamente una tupla valida o il descrittore di base della tupla non sia mai stato creato, ad esempio perchè la tabella
+	 * non ha più le stesse colonne. La funzione riconosce anche il formato, contenente i nomi delle colonne, utilizzato dalle versioni precedenti.
+	 * Il formato è descritto in record.cpp.
 	 */
 	std::streamoff size() const throw ();
-	void write (std::fstream& stream) const	throw (storage_exception&);
-	void read (std::fstream& stream) throw (storage_exception&);
+	void write (std::string& buffer) const throw ();
+
+	/* La funzione peek legge lo stato e la visibilità della tupla memorizzata nei size byte puntati da buffer, senza ricostruirla e senza che il suo
+	 * descrittore debba essere noto. Restituisce false se il buffer è troppo piccolo per contenere una tupla.
+	 */
+	static bool peek (const char* buffer, std::streamoff size, enum state& _state, bool& _visible) throw ();
+
+	/* La funzione project restituisce i valori correnti delle colonne columns della tupla memorizzata nei size byte puntati da buffer, esattamente come
+	 * current(columns), senza ricostruirla: i valori delle altre colonne vengono saltati, grazie alla loro lunghezza, senza essere copiati. Può generare le
+	 * stesse eccezioni della funzione read.
+	 */
+	static std::unique_ptr<std::unordered_map<std::string, std::string>> project (const char* buffer, std::streamoff size, const std::list<std::string>& columns) throw (storage_exception&);
+
+	/* La funzione footprint restituisce una stima dei byte di memoria occupati dalla tupla, compresi quelli allocati dinamicamente dai contenitori che la
+	 * compongono. Vedi hybrid_storage.hpp.
+	 */
+	std::size_t footprint () const throw ();
+	void read (const char* buffer, std::streamoff size) throw (storage_exception&);
+
+	/* La funzione statica write serializza, accodandola al buffer, la tupla che verrebbe costruita a partire da valuesMap, columnsMap e _state (vedi costruttore),
+	 * senza costruire l'oggetto record: il risultato è identico a quello che si otterrebbe costruendo la tupla e chiamandone la funzione write. Viene usata per
+	 * i caricamenti massivi (vedi file_storage::begin_bulk).
+	 * Può generare le stesse eccezioni del costruttore; in tal caso il buffer non viene modificato.
+	 */
+	static void write (std::string& buffer, std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum state _state) throw (basic_exception&);
 
 private:
+	/* column_storage (vedi column_storage.hpp) scompone le tuple nelle proprie colonne e le ricompone quando vengono lette. */
+	friend class column_storage;
+
+	/* I valori correnti sono memorizzati in __current, nell'ordine delle colonne di __descriptor, nella rappresentazione nativa del tipo della colonna
+	 * quando possibile (vedi cell.hpp). I valori precedenti vengono memorizzati in __old solo quando almeno uno di essi non è vuoto, ossia quando la tupla
+	 * viene aggiornata; altrimenti __old è vuoto e tutti i valori precedenti sono stringhe vuote.
+	 */
+	typedef std::vector<cell, arena_allocator<cell>> cell_vector;
+
 	enum state											__state;
-	struct 	value {
-		std::string current;
-		std::string old;
-		value (std::string c, std::string o) : current(c), old(o) {}
-	};
-	std::unordered_map<std::string, value>				__valueMap;
+	const descriptor*									__descriptor;
+	cell_vector											__current;
+	cell_vector											__old;
 	bool												__visible;
 
-	void validate_column_name(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) const throw (column_not_exists&);
-	void validate_columns_value(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (data_exception&);
-	void build_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (empty_key&);
-	void update_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw ();
+	static void validate_column_name(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (column_not_exists&);
+	static void validate_columns_value(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap) throw (data_exception&);
+	static void assign_value(cell& _cell, const std::string& name, const std::string& value, const column& _column, arena* _arena, dictionary* _dictionary) throw ();
+	void build_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw (empty_key&);
+	static const descriptor* present_columns(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, std::vector<std::unordered_map<std::string, std::string>::const_iterator>& present) throw (empty_key&);
+	void read_legacy (const char* buffer, const char* end) throw (storage_exception&);
+	void update_value_map(std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw ();
+
+	/* La funzione add_columns aggiunge alla tupla le colonne added, che non contiene, con i valori presenti in valueMap, sostituendo il descrittore. */
+	void add_columns(const std::vector<std::string>& added, std::unordered_map<std::string, std::string>& valueMap, std::unordered_map<std::string, column>& columnsMap, dictionary* _dictionary) throw ();
+	bool resolve (const handle& _handle) const throw ();
 
 };	/*	end of record declaration	*/
 }; 	/*	end of openDB namespace	*/
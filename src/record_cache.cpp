@@ -0,0 +1,70 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "record_cache.hpp"
+using namespace openDB;
+
+const record* record_cache::find (unsigned long ID) throw () {
+	std::unordered_map<unsigned long, entries::iterator>::const_iterator it = __map.find(ID);
+	if (it == __map.end()) {
+		__misses++;
+		return 0;
+	}
+	__hits++;
+	__entries.splice(__entries.begin(), __entries, it->second);
+	return &it->second->second;
+}
+
+void record_cache::insert (unsigned long ID, record&& _record) throw () {
+	if (__capacity == 0)
+		return;
+	std::unordered_map<unsigned long, entries::iterator>::iterator it = __map.find(ID);
+	if (it != __map.end()) {
+		it->second->second = std::move(_record);
+		__entries.splice(__entries.begin(), __entries, it->second);
+		return;
+	}
+	__entries.push_front(std::pair<unsigned long, record>(ID, std::move(_record)));
+	__map.insert(std::pair<unsigned long, entries::iterator>(ID, __entries.begin()));
+	capacity(__capacity);
+}
+
+void record_cache::erase (unsigned long ID) throw () {
+	std::unordered_map<unsigned long, entries::iterator>::iterator it = __map.find(ID);
+	if (it != __map.end()) {
+		__entries.erase(it->second);
+		__map.erase(it);
+	}
+}
+
+void record_cache::clear () throw () {
+	__entries.clear();
+	__map.clear();
+	__hits = 0;
+	__misses = 0;
+}
+
+void record_cache::capacity (std::size_t _capacity) throw () {
+	__capacity = _capacity;
+	while (__entries.size() > __capacity) {
+		__map.erase(__entries.back().first);
+		__entries.pop_back();
+	}
+}
+
+record_cache::statistics record_cache::stats () const throw () {
+	statistics _stats;
+	_stats.hits = __hits;
+	_stats.misses = __misses;
+	_stats.entries = __entries.size();
+	_stats.capacity = __capacity;
+	return _stats;
+}
@@ -0,0 +1,74 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_RECORD_CACHE_HEADER__
+#define __OPENDB_RECORD_CACHE_HEADER__
+
+#include "record.hpp"
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace openDB {
+/* La classe record_cache mantiene in memoria, già deserializzati, gli ultimi record letti o scritti da un gestore su file (vedi file_storage.hpp), fino ad un
+ * numero massimo di record stabilito, in modo che gli accessi ripetuti agli stessi record non richiedano operazioni di I/O né di deserializzazione.
+ * Quando il limite viene raggiunto, viene rimosso il record usato meno di recente (LRU). Una capacità nulla disabilita la cache.
+ * La cache non si occupa della coerenza dei record: è compito del gestore aggiornare o rimuovere un record ogni volta che lo modifica o lo cancella.
+ */
+class record_cache {
+public:
+		/* La struttura statistics raccoglie i contatori relativi all'utilizzo della cache:
+		 * 	- hits: numero di ricerche che hanno trovato il record nella cache;
+		 * 	- misses: numero di ricerche che non hanno trovato il record nella cache;
+		 * 	- entries: numero di record attualmente contenuti nella cache;
+		 * 	- capacity: numero massimo di record che la cache può contenere.
+		 */
+		struct statistics {
+				unsigned long	hits;
+				unsigned long	misses;
+				std::size_t		entries;
+				std::size_t		capacity;
+				statistics() : hits(0), misses(0), entries(0), capacity(0) {}
+		};
+
+		explicit record_cache (std::size_t capacity = default_capacity) throw () : __capacity(capacity), __hits(0), __misses(0) {}
+
+		/* La funzione find restituisce il record con chiave ID, se è contenuto nella cache, marcandolo come il più recente; altrimenti restituisce 0.
+		 * L'indirizzo restituito resta valido fino alla successiva modifica della cache.
+		 */
+		const record* find (unsigned long ID) throw ();
+
+		/* La funzione insert inserisce nella cache il record _record con chiave ID, sostituendo quello eventualmente già presente, e rimuove il record usato meno
+		 * di recente se la cache è piena. La funzione erase rimuove il record con chiave ID, se presente.
+		 */
+		void insert (unsigned long ID, record&& _record) throw ();
+		void erase (unsigned long ID) throw ();
+
+		/* La funzione clear svuota la cache e azzera i contatori. La funzione capacity modifica il numero massimo di record, rimuovendo quelli in eccesso.
+		 */
+		void clear () throw ();
+		void capacity (std::size_t _capacity) throw ();
+
+		statistics stats () const throw ();
+
+		static const std::size_t default_capacity = 1024;
+
+private:
+		typedef std::list<std::pair<unsigned long, record>> entries;
+
+		std::size_t											__capacity;
+		entries												__entries;		/*	record nella cache, dal più recente al meno recente	*/
+		std::unordered_map<unsigned long, entries::iterator>	__map;
+		unsigned long										__hits;
+		unsigned long										__misses;
+};
+}; /*	end of openDB namespace	*/
+#endif
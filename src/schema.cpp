@@ -21,7 +21,7 @@
 
 using namespace openDB;
 
-schema::schema (std::string schemaName, std::string storageDirectory, database* parent) throw (basic_exception&) : __parent(parent) {
+schema::schema (std::string schemaName, std::string storageDirectory, database* parent, bool reattach) throw (basic_exception&) : __parent(parent), __reattach(reattach) {
 	(!schemaName.empty() ? __schemaName = schemaName : throw access_exception("Error creating schema: you can not create a schema with no name. Check the 'schemaName' paramether."));
 	#if !defined __WINDOWS_COMPILING_
 		(!storageDirectory.empty() ? __storageDirectory = storageDirectory + __schemaName + "/" : throw storage_exception("Error creating schema '" + schemaName + "': you must specify where to store this schema. Check the 'storageDirectory' paramether."));
@@ -60,17 +60,17 @@ std::unique_ptr<std::list<std::string>> schema::commit() const throw () {
 	std::unique_ptr<std::list <std::string>> list_ptr(new std::list<std::string>);
 	for (std::unordered_map <std::string, table>::const_iterator table_it = __tablesMap.begin(); table_it != __tablesMap.end(); table_it++) {
 		if (!table_it->second.manages_result()) {
-			std::unique_ptr<std::list<unsigned long>> ID_list = table_it->second.internalID();
-			for(std::list<unsigned long>::const_iterator ID_it = ID_list->begin(); ID_it !=  ID_list->end(); ID_it++)
-				switch(table_it->second.state(*ID_it)) {
+			std::unique_ptr<std::list<unsigned long>> pending = table_it->second.pending();
+			for (std::list<unsigned long>::const_iterator it = pending->begin(); it != pending->end(); it++)
+				switch(table_it->second.state(*it)) {
 					case record::inserting:
-						list_ptr->push_back(insert_sql(table_it->first, *ID_it));
+						list_ptr->push_back(insert_sql(table_it->first, *it));
 						break;
 					case record::updating:
-						list_ptr->push_back(update_sql(table_it->first, *ID_it));
+						list_ptr->push_back(update_sql(table_it->first, *it));
 						break;
 					case record::deleting:
-						list_ptr->push_back(delete_sql(table_it->first, *ID_it));
+						list_ptr->push_back(delete_sql(table_it->first, *it));
 						break;
 					default: break;
 					}
@@ -113,15 +113,27 @@ std::string schema::insert_sql(std::string tableName, unsigned long ID) const th
 	if (it != __tablesMap.end()) {
 		std::string sql_column;
 		std::string sql_values;
-		std::unique_ptr<std::unordered_map<std::string, std::string>> value_map_ptr = it->second.current(ID);
-		for (std::unordered_map<std::string, std::string>::const_iterator value_it = value_map_ptr->begin(); value_it != value_map_ptr->end(); value_it++) {
-			if (!sql_column.empty())
-				sql_column+= ", ";
-			sql_column += value_it->first;
-			if (!sql_values.empty())
-				sql_values += ", ";
-			sql_values += it->second.get_column(value_it->first).prepare_value(value_it -> second);
-		}
+		class insert_values : public storage::visitor {
+		public :
+			insert_values (const table& _table, std::string& sql_column, std::string& sql_values) : __table(_table), __sql_column(sql_column), __sql_values(sql_values) {}
+			virtual void visit (unsigned long, const record& _record) throw (basic_exception&) {
+				field value;
+				for (std::size_t i = 0; i < _record.fields(); i++) {
+					_record.current(i, value);
+					if (!__sql_column.empty())
+						__sql_column += ", ";
+					__sql_column += _record.name(i);
+					if (!__sql_values.empty())
+						__sql_values += ", ";
+					__sql_values += __table.get_column(_record.name(i)).prepare_value(value.str());
+				}
+			}
+		private :
+			const table& __table;
+			std::string& __sql_column;
+			std::string& __sql_values;
+		} values(it->second, sql_column, sql_values);
+		it->second.visit(ID, values);
 
 		std::string sql_command = "insert into " + __schemaName + "." + tableName + " (" + sql_column + ") values (" + sql_values + ")";
 		return sql_command;
@@ -135,31 +147,44 @@ std::string schema::update_sql(std::string tableName, unsigned long ID) const th
 	if (it != __tablesMap.end()) {
 		std::string sql_value;
 		std::string sql_where;
-		std::unique_ptr<std::unordered_map<std::string, std::string>> value_map_ptr = it->second.current(ID);
-		std::unique_ptr<std::unordered_map<std::string, std::string>> old_map_ptr = it->second.old(ID);
-		for (std::unordered_map<std::string, std::string>::const_iterator value_it = value_map_ptr->begin(); value_it != value_map_ptr->end(); value_it++) {
-			if (it->second.get_column(value_it->first).is_key()) {
-				if (!sql_where.empty())
-					sql_where += " and ";
-				sql_where += value_it -> first + "=" + it->second.get_column(value_it->first).prepare_value(value_it -> second);
-			}
-			else {
-				if (old_map_ptr->find(value_it->first)->second != value_it->second) { //controllo che i valori del record non coincidano prima generare il comando per il loro aggiornamento
-					if (!sql_value.empty())
-						sql_value += ", ";
-					sql_value += value_it -> first + "=" + it->second.get_column(value_it->first).prepare_value(value_it -> second);
+		class update_values : public storage::visitor {
+		public :
+			update_values (const table& _table, std::string& sql_value, std::string& sql_where) : __table(_table), __sql_value(sql_value), __sql_where(sql_where) {}
+			virtual void visit (unsigned long, const record& _record) throw (basic_exception&) {
+				field value, old_value;
+				for (std::size_t i = 0; i < _record.fields(); i++) {
+					const column& _column = __table.get_column(_record.name(i));
+					_record.current(i, value);
+					if (_column.is_key()) {
+						if (!__sql_where.empty())
+							__sql_where += " and ";
+						__sql_where += _record.name(i) + "=" + _column.prepare_value(value.str());
+					}
+					else {
+						_record.old(i, old_value);
+						if (old_value != value) { //controllo che i valori del record non coincidano prima generare il comando per il loro aggiornamento
+							if (!__sql_value.empty())
+								__sql_value += ", ";
+							__sql_value += _record.name(i) + "=" + _column.prepare_value(value.str());
+						}
+					}
 				}
-			}
-		}
 
-		if (sql_where.empty()) {
-			std::unique_ptr<std::unordered_map<std::string, std::string>> old_value_map_ptr = it->second.old(ID);
-			for (std::unordered_map<std::string, std::string>::const_iterator value_it = old_value_map_ptr->begin(); value_it != old_value_map_ptr->end(); value_it++) {
-				if (!sql_where.empty())
-					sql_where += " and ";
-				sql_where += value_it -> first + "=" + it->second.get_column(value_it->first).prepare_value(value_it -> second);
+				if (__sql_where.empty()) {
+					for (std::size_t i = 0; i < _record.fields(); i++) {
+						_record.old(i, old_value);
+						if (!__sql_where.empty())
+							__sql_where += " and ";
+						__sql_where += _record.name(i) + "=" + __table.get_column(_record.name(i)).prepare_value(old_value.str());
+					}
+				}
 			}
-		}
+		private :
+			const table& __table;
+			std::string& __sql_value;
+			std::string& __sql_where;
+		} values(it->second, sql_value, sql_where);
+		it->second.visit(ID, values);
 
 		std::string sql_command = "update " + __schemaName + "." + tableName + " set " + sql_value + " where " + sql_where;
 		return sql_command;
@@ -172,22 +197,35 @@ std::string schema::delete_sql(std::string tableName, unsigned long ID) const th
 	std::unordered_map <std::string, table>::const_iterator it = __tablesMap.find(tableName);
 	if (it != __tablesMap.end()) {
 		std::string sql_where;
-		std::unique_ptr<std::unordered_map<std::string, std::string>> value_map_ptr = it->second.current(ID);
-		for (std::unordered_map<std::string, std::string>::const_iterator value_it = value_map_ptr->begin(); value_it != value_map_ptr->end(); value_it++)
-			if (it->second.get_column(value_it->first).is_key()) {
-				if (!sql_where.empty())
-					sql_where += " and ";
-				sql_where += value_it -> first + "=" + it->second.get_column(value_it->first).prepare_value(value_it -> second);
-			}
+		class delete_values : public storage::visitor {
+		public :
+			delete_values (const table& _table, std::string& sql_where) : __table(_table), __sql_where(sql_where) {}
+			virtual void visit (unsigned long, const record& _record) throw (basic_exception&) {
+				field value;
+				for (std::size_t i = 0; i < _record.fields(); i++) {
+					const column& _column = __table.get_column(_record.name(i));
+					if (_column.is_key()) {		//soltanto i valori delle colonne chiave
+						_record.current(i, value);
+						if (!__sql_where.empty())
+							__sql_where += " and ";
+						__sql_where += _record.name(i) + "=" + _column.prepare_value(value.str());
+					}
+				}
 
-		if (sql_where.empty()) {
-			std::unique_ptr<std::unordered_map<std::string, std::string>> old_value_map_ptr = it->second.old(ID);
-			for (std::unordered_map<std::string, std::string>::const_iterator value_it = old_value_map_ptr->begin(); value_it != old_value_map_ptr->end(); value_it++) {
-				if (!sql_where.empty())
-					sql_where += " and ";
-				sql_where += value_it -> first + "=" + it->second.get_column(value_it->first).prepare_value(value_it -> second);
+				if (__sql_where.empty()) {
+					for (std::size_t i = 0; i < _record.fields(); i++) {
+						_record.old(i, value);
+						if (!__sql_where.empty())
+							__sql_where += " and ";
+						__sql_where += _record.name(i) + "=" + __table.get_column(_record.name(i)).prepare_value(value.str());
+					}
+				}
 			}
-		}
+		private :
+			const table& __table;
+			std::string& __sql_where;
+		} values(it->second, sql_where);
+		it->second.visit(ID, values);
 
 		std::string sql_command = "delete from " + __schemaName + "." + tableName + " where " + sql_where;;
 		return sql_command;
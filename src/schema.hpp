@@ -30,8 +30,9 @@ public :
 		 *  - storageDirectory: il percorso dove viene creato l'albero di directory preposto alla memorizzazione delle tuple gestire dalle tabelle che compongono
 		 * 						lo schema. Se non viene specificato viene generata una eccezione di tipo 'storage_exception', derivata di 'basic_exception'.
 		 * - parent: puntatore al database 'padre', ossia l'oddetto database che contiene lo schema.
+		 * - reattach: se true, le tabelle aggiunte allo schema riutilizzano le righe memorizzate su file da una precedente esecuzione (vedi table.hpp).
 		 */
-		schema (std::string schemaName, std::string storageDirectory, database* parent = 0) throw (basic_exception&);
+		schema (std::string schemaName, std::string storageDirectory, database* parent = 0, bool reattach = false) throw (basic_exception&);
 
 		/* Questa funzione restituisce il nome di uno schema. Il nome di ogni schema all'interno di uno stesso database deve essere univoco (vedi oggetto
 		 * database, definito in database.hpp) perché usato per l'accesso ad esse.
@@ -45,7 +46,7 @@ public :
 		 * Se il nome della tabella non viene specificato, viene generata una eccezione di tipo	access_exception.
 		 */
 		void add_table(std::string tableName) throw (basic_exception&)
-			{(find_table(tableName) ? throw table_exists("Table '" + tableName + "' already exists in schema '" + __schemaName + "'") : __tablesMap.insert(std::pair<std::string, table>(tableName, table(tableName, __storageDirectory, this))));}
+			{(find_table(tableName) ? throw table_exists("Table '" + tableName + "' already exists in schema '" + __schemaName + "'") : __tablesMap.insert(std::pair<std::string, table>(tableName, table(tableName, __storageDirectory, this, false, table::on_file, __reattach))));}
 
 		/*	Restituisce il numero di tabelle che compongono lo schema.
 		 */
@@ -91,6 +92,7 @@ public :
 		 * effettuare sul database remoto a fronte delle modifiche apportate localmente ai record gestiti dalle tabelle che compongono l'oggetto schema considerato.
 		 * Ciascuno di questi comandi deve essere inviato al database remoto. Nessuna modifica viene effettuata sui record dopo la generazione dei comandi sql, quindi sa'
 		 * necessario ricaricarli dal database.
+		 * Vengono considerate soltanto le righe modificate di ciascuna tabella (vedi table::pending), nell'ordine delle rispettive chiavi.
 		 */
 		std::unique_ptr<std::list<std::string>> commit() const throw ();
 
@@ -105,6 +107,7 @@ private :
 																			 * 	compongono la struttura dello schema
 																			 */
 		database* __parent; /*	puntatore al database contenente lo schema 	*/
+		bool										__reattach;				/*	se true, le tabelle riutilizzano le righe memorizzate su file da una precedente esecuzione	*/
 		std::unordered_map<std::string, table>		__tablesMap;			/*	mappa delle tabelle che compongono lo schema
 																			 *	Le tabelle vengono organizzate in una struttura di tipo 'unordered_map', ossia un contenitore di tipo
 																			 *  associativo che consente di accedere a qualsiasi posizione in tempo costante. Le chiavi di accesso a
@@ -34,6 +34,16 @@ namespace sqlType {
 
 struct type_info;
 
+/* native_type indica la rappresentazione binaria nativa in cui i valori di un tipo possono essere memorizzati all'interno delle tuple (vedi cell.hpp):
+ * 	- as_text : il valore viene memorizzato come stringa;
+ * 	- as_integer : intero con segno a 64 bit;
+ * 	- as_float, as_double : numero in virgola mobile a precisione singola o doppia;
+ * 	- as_decimal : intero a 64 bit scalato di una potenza di dieci;
+ * 	- as_date, as_time : data o orario compattati in un intero;
+ * 	- as_boolean : indice della stringa con cui il valore è stato espresso.
+ */
+enum native_type {as_text, as_integer, as_float, as_double, as_decimal, as_date, as_time, as_boolean};
+
 /* type_base è la classe base da cui derivano concettualmente tutti i tipi di dato della trasposizione c++ dei tipi sql. Essa è una classe astratta senza attributi e con soltanto
  * due membri virtuali astratti, validate_value e prepare_value, le quali definiscono la firma delle funzioni per la validazione di un valore e la sua preparazione precedente alla
  * generazione di un comando sql.
@@ -55,6 +65,11 @@ public:
 		virtual std::string prepare_value(std::string value) const throw () = 0;
 
 		virtual struct type_info get_type_info() const throw () = 0;
+
+		/* La funzione native restituisce la rappresentazione nativa dei valori del tipo. Per i tipi che non ne hanno una, i valori vengono memorizzati come stringhe.
+		 */
+		virtual enum native_type native() const throw ()
+			{return as_text;}
 };
 
 /*
@@ -84,6 +99,8 @@ public:
 		virtual std::string prepare_value(std::string value) const throw ();
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_boolean;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -115,6 +132,8 @@ public:
 			{return "'" + value + "'";}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_date;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -159,6 +178,8 @@ public:
 			{return "'" + value + "'";}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_time;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -268,6 +289,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_integer;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -291,6 +314,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_integer;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -316,6 +341,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_integer;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -347,6 +374,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_float;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -376,6 +405,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_double;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
@@ -415,6 +446,8 @@ public:
 			{return value;}
 
 		virtual struct type_info get_type_info() const throw ();
+		virtual enum native_type native() const throw ()
+			{return as_decimal;}
 
 		static const std::string type_name;
 		static const std::string udt_name;
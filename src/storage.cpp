@@ -0,0 +1,171 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "storage.hpp"
+#include "thread_pool.hpp"
+#include <exception>
+#include <deque>
+
+using namespace openDB;
+
+void storage::parallel_scan (reducer& _reducer, unsigned threads) const throw (basic_exception&) {
+	/* morsel conserva una copia dei record di un blocco, riutilizzandone le celle da un blocco all'altro */
+	class morsel : public visitor {
+	public :
+		morsel () : __size(0) {}
+		virtual void visit (unsigned long ID, const record& _record) throw (basic_exception&) {
+			if (__size == __records.size()) {
+				__IDs.push_back(ID);
+				__records.push_back(_record);
+			}
+			else {
+				__IDs[__size] = ID;
+				__records[__size] = _record;
+			}
+			__size++;
+		}
+		std::vector<unsigned long> __IDs;
+		std::vector<record> __records;
+		std::size_t __size;
+	};
+
+	/* Se il gestore non consente la lettura in parallelo, il lavoratore zero legge i record con la funzione scan, nell'ordine più rapido per il gestore, e
+	 * accoda i blocchi agli altri lavoratori; se la coda è piena visita da sé il blocco appena letto, per cui non resta mai in attesa.
+	 */
+	class morsel_task : public thread_pool::task {
+	public :
+		morsel_task (const storage& _storage, std::vector<std::unique_ptr<reducer>>& partials) :
+			__storage(_storage), __partials(partials), __morsels(_storage.morsels()), __next(0), __failed(false), __done(false) {}
+		virtual void run (unsigned worker) throw () {
+			try {
+				if (__morsels > 0)
+					for (std::size_t _morsel = __next++; _morsel < __morsels && !__failed; _morsel = __next++)
+						__storage.visit_morsel(_morsel, *__partials[worker]);
+				else if (worker == 0)
+					produce();
+				else
+					consume(worker);
+			}
+			catch (...) {
+				fail();
+			}
+		}
+		std::exception_ptr error () const
+			{return __error;}
+	private :
+		const storage& __storage;
+		std::vector<std::unique_ptr<reducer>>& __partials;
+		std::size_t __morsels;
+		std::atomic<std::size_t> __next;
+		std::atomic<bool> __failed;
+		std::mutex __mutex;
+		std::condition_variable __ready;
+		std::deque<std::unique_ptr<morsel>> __queue;
+		std::vector<std::unique_ptr<morsel>> __free;
+		bool __done;
+		std::exception_ptr __error;
+
+		class feeder : public visitor {
+		public :
+			explicit feeder (morsel_task& _task) : __task(_task), __morsel(new morsel) {}
+			virtual void visit (unsigned long ID, const record& _record) throw (basic_exception&) {
+				if (__task.__failed)
+					throw storage_exception("Scan interrupted.");
+				__morsel->visit(ID, _record);
+				if (__morsel->__size == morsel_rows)
+					__task.submit(__morsel);
+			}
+			morsel_task& __task;
+			std::unique_ptr<morsel> __morsel;
+		};
+
+		void fail () throw () {
+			std::lock_guard<std::mutex> lock(__mutex);
+			if (!__error)
+				__error = std::current_exception();
+			__failed = true;
+		}
+		void process (unsigned worker, morsel& _morsel) throw (basic_exception&) {
+			for (std::size_t i = 0; i < _morsel.__size && !__failed; i++)
+				__partials[worker]->visit(_morsel.__IDs[i], _morsel.__records[i]);
+			_morsel.__size = 0;
+		}
+		void submit (std::unique_ptr<morsel>& _morsel) throw (basic_exception&) {
+			{
+				std::lock_guard<std::mutex> lock(__mutex);
+				if (__queue.size() < 2 * __partials.size()) {
+					__queue.push_back(std::move(_morsel));
+					if (__free.empty())
+						_morsel.reset(new morsel);
+					else {
+						_morsel = std::move(__free.back());
+						__free.pop_back();
+					}
+				}
+			}
+			if (_morsel->__size == 0)
+				__ready.notify_one();
+			else
+				process(0, *_morsel);
+		}
+		void produce () throw (basic_exception&) {
+			feeder _feeder(*this);
+			try {
+				__storage.scan(_feeder);
+				process(0, *_feeder.__morsel);
+			}
+			catch (...) {
+				fail();
+			}
+			{
+				std::lock_guard<std::mutex> lock(__mutex);
+				__done = true;
+			}
+			__ready.notify_all();
+			consume(0);
+		}
+		void consume (unsigned worker) throw (basic_exception&) {
+			while (true) {
+				std::unique_ptr<morsel> _morsel;
+				{
+					std::unique_lock<std::mutex> lock(__mutex);
+					while (__queue.empty() && !__done)
+						__ready.wait(lock);
+					if (__queue.empty())
+						return;
+					_morsel = std::move(__queue.front());
+					__queue.pop_front();
+				}
+				process(worker, *_morsel);
+				std::lock_guard<std::mutex> lock(__mutex);
+				__free.push_back(std::move(_morsel));
+			}
+		}
+	};
+
+	thread_pool& pool = thread_pool::global();
+	std::size_t count = morsels();
+	if (count == 0)
+		count = (numRecords() + morsel_rows - 1) / morsel_rows;
+	std::size_t workers = (threads == 0 ? pool.size() : threads);
+	if (workers > count)
+		workers = (count > 0 ? count : 1);
+
+	std::vector<std::unique_ptr<reducer>> partials;
+	for (std::size_t i = 0; i < workers; i++)
+		partials.push_back(_reducer.fork());
+	morsel_task _task(*this, partials);
+	pool.run(_task, workers);
+	if (_task.error())
+		std::rethrow_exception(_task.error());
+	for (std::vector<std::unique_ptr<reducer>>::iterator it = partials.begin(); it != partials.end(); it++)
+		_reducer.merge(**it);
+}
@@ -14,7 +14,9 @@
 #define __OPENDB_STORAGE_HEADER__
 
 #include "record.hpp"
+#include "dictionary.hpp"
 #include <list>
+#include <map>
 
 namespace openDB {
 /* La classe storage è una classe astratta il cui compito è definire una interfaccia mendiante la quale un oggetto table (vedi header table.hpp) comunica con l'oggetto
@@ -68,6 +70,13 @@ public :
 	 	 */
 		virtual unsigned long insert (std::unordered_map<std::string, std::string>& valuesMap, std::unordered_map<std::string, column>& columnsMap, enum record::state _state) throw (basic_exception&) = 0;
 
+		/* La seconda versione della funzione insert inserisce tutte le tuple di _batch (vedi record::batch) nello stato _state, con il risultato che si
+		 * otterrebbe inserendole una alla volta con la prima versione, ma risolvendo le colonne una sola volta per l'intero batch. Le tuple ricevono chiavi
+		 * consecutive, nell'ordine del batch, e viene restituita la chiave della prima. Può generare le stesse eccezioni della prima versione, ad eccezione di
+		 * quelle già generate dal costruttore del batch; se uno dei valori non è valido, le tuple che lo precedono restano inserite.
+		 */
+		virtual unsigned long insert (const record::batch& _batch, enum record::state _state) throw (basic_exception&) = 0;
+
 		/* La funzione update consente di marcare i valori di un record affinchè siano aggiornati correttamente dal database remoto. Prende i seguenti parametri:
 		 * consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
 		 * 	- valueMap : mappa il cui primo campo è il nome della colonna in cui inserire il valore contenuto nel secondo campo. Se non esiste nessuna colonna con il nome
@@ -125,8 +134,248 @@ public :
 		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID) const throw (storage_exception&) = 0;
 		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID) const throw (storage_exception&) = 0;
 
+		/* La seconda versione della funzione current restituisce soltanto i valori correnti delle colonne columns, ad esempio quelle che compongono la chiave;
+		 * le colonne che il record non contiene vengono ignorate. La versione predefinita filtra i valori restituiti da current(ID); i gestori che memorizzano
+		 * i record serializzati decodificano soltanto i valori richiesti (vedi record::project).
+		 * La funzione può generare una eccezione di tipo 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con la chiave contenuta nel
+		 * parametro ID specifico
+		 */
+		virtual std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (storage_exception&) {
+			std::unique_ptr<std::unordered_map<std::string, std::string>> values = current(ID);
+			std::unique_ptr<std::unordered_map<std::string, std::string>> map_ptr(new std::unordered_map<std::string, std::string>);
+			for (std::list<std::string>::const_iterator it = columns.begin(); it != columns.end(); it++) {
+				std::unordered_map<std::string, std::string>::iterator value_it = values->find(*it);
+				if (value_it != values->end())
+					map_ptr->insert(*value_it);
+			}
+			return map_ptr;
+		}
+
+		/* La funzione fetch restituisce i valori correnti dei record le cui chiavi sono contenute in IDs, nello stesso ordine, esattamente come se venisse chiamata
+		 * la funzione current per ciascuno di essi. Un gestore può però leggere i record contemporaneamente anziché uno alla volta (vedi file_storage.hpp), per
+		 * cui è opportuno usare questa funzione quando bisogna accedere a molti record.
+		 * La funzione può generare una eccezione di tipo 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con una delle chiavi
+		 * contenute in IDs.
+		 */
+		virtual std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> fetch (const std::list<unsigned long>& IDs) const throw (storage_exception&) {
+			std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> list_ptr(new std::list<std::unordered_map<std::string, std::string>>);
+			for (std::list<unsigned long>::const_iterator it = IDs.begin(); it != IDs.end(); it++)
+				list_ptr->push_back(std::move(*current(*it)));
+			return list_ptr;
+		}
+
+		/* La funzione pending restituisce, in ordine crescente, le chiavi dei record in stato inserting, updating o deleting, cioè di quelli per i quali
+		 * bisogna inviare un comando al database remoto all'atto del commit (vedi schema::commit). Il gestore ne tiene traccia man mano che i record vengono
+		 * inseriti, aggiornati, marcati per la rimozione o rimossi, per cui il costo della funzione è proporzionale al numero di record modificati e non a
+		 * quello dei record gestiti.
+		 * La funzione pending_changes restituisce il numero di record in ciascuno dei tre stati.
+		 */
+		std::unique_ptr<std::list<unsigned long>> pending () const throw () {
+			std::unique_ptr<std::list<unsigned long>> list_ptr(new std::list<unsigned long>);
+			for (std::map<unsigned long, enum record::state>::const_iterator it = __pending.begin(); it != __pending.end(); it++)
+				list_ptr->push_back(it->first);
+			return list_ptr;
+		}
+		struct changes {
+				changes () : inserting(0), updating(0), deleting(0) {}
+				unsigned long	inserting;
+				unsigned long	updating;
+				unsigned long	deleting;
+		};
+		changes pending_changes () const throw () {
+			changes _changes;
+			for (std::map<unsigned long, enum record::state>::const_iterator it = __pending.begin(); it != __pending.end(); it++)
+				switch (it->second) {
+					case record::inserting: _changes.inserting++; break;
+					case record::updating: _changes.updating++; break;
+					case record::deleting: _changes.deleting++; break;
+					default: break;
+				}
+			return _changes;
+		}
+
+		/* La classe visitor consente di accedere a tutti i record gestiti attraverso la funzione scan, che chiama la funzione visit una volta per ciascun record,
+		 * passandole la chiave e il record stesso. Il record passato a visit è valido solo per la durata della chiamata.
+		 */
+		class visitor {
+		public :
+				virtual ~visitor () {}
+				virtual void visit (unsigned long ID, const record& _record) throw (basic_exception&) = 0;
+		};
+
+		/* La funzione scan visita tutti i record gestiti, in un ordine scelto dal gestore in modo da rendere la lettura il più possibile sequenziale (vedi
+		 * file_storage.hpp): è il modo più efficiente per accedere a tutti i record, ad esempio per copiarli o visualizzarli. Durante la visita non è possibile
+		 * modificare il gestore. La funzione propaga le eccezioni generate da _visitor e può generare una eccezione di tipo io_error se non è possibile leggere
+		 * un record.
+		 */
+		virtual void scan (visitor& _visitor) const throw (basic_exception&) = 0;
+
+		/* La funzione visit chiama la funzione visit di _visitor per il solo record ID, consentendo di leggerne i valori senza copiarli (vedi record::current).
+		 * Il record viene letto come farebbe la funzione current. Oltre a quelle generate da _visitor, la funzione può generare una eccezione di tipo
+		 * 'record_not_exists' se non esiste nessun record che sia in corrispondenza valida con la chiave ID.
+		 */
+		virtual void visit (unsigned long ID, visitor& _visitor) const throw (basic_exception&) = 0;
+
+		/* La classe column_visitor consente di leggere i valori di alcune colonne di tutti i record attraverso la seconda versione della funzione scan, che
+		 * chiama la funzione visit una volta per ciascun record passandole la chiave e, in values, i valori delle colonne richieste, nello stesso ordine (vedi
+		 * field in cell.hpp); present[i] è false, e values[i] è vuoto, se il record non contiene la colonna i. I valori sono validi solo per la durata della
+		 * chiamata.
+		 * La versione predefinita della funzione scan legge i valori dai record visitati dalla prima versione; un gestore che memorizza i valori per colonna
+		 * (vedi column_storage.hpp) legge soltanto le colonne richieste, senza ricomporre i record. Durante la visita non è possibile modificare il gestore.
+		 */
+		class column_visitor {
+		public :
+				virtual ~column_visitor () {}
+				virtual void visit (unsigned long ID, const std::vector<field>& values, const std::vector<bool>& present) throw (basic_exception&) = 0;
+		};
+		virtual void scan (const std::vector<std::string>& columns, column_visitor& _visitor) const throw (basic_exception&) {
+			class projector : public visitor {
+			public :
+				projector (const std::vector<std::string>& columns, column_visitor& _visitor) : __visitor(_visitor), __values(columns.size()), __present(columns.size()) {
+					for (std::vector<std::string>::const_iterator it = columns.begin(); it != columns.end(); it++)
+						__handles.push_back(record::handle(*it));
+				}
+				virtual void visit (unsigned long ID, const record& _record) throw (basic_exception&) {
+					for (std::size_t i = 0; i < __handles.size(); i++)
+						if (!(__present[i] = _record.current(__handles[i], __values[i])))
+							__values[i] = field();
+					__visitor.visit(ID, __values, __present);
+				}
+			private :
+				column_visitor& __visitor;
+				std::vector<record::handle> __handles;
+				std::vector<field> __values;
+				std::vector<bool> __present;
+			} _projector(columns, _visitor);
+			scan(_projector);
+		}
+
+		/* La classe cursor consente di scorrere le chiavi dei record gestiti una alla volta, senza costruirne l'elenco completo come fa la funzione internalID:
+		 * la scansione può quindi iniziare subito ed essere interrotta in qualsiasi momento. Un oggetto cursor viene restituito dalla funzione rows ed è
+		 * posizionato prima del primo record.
+		 * 	- next si sposta sul record successivo; restituisce false se non ce ne sono altri;
+		 * 	- ID restituisce la chiave del record corrente;
+		 * 	- visit chiama la funzione visit di _visitor per il record corrente (vedi la funzione visit del gestore).
+		 * Durante la scansione i record possono essere letti, modificati (update e cancel) o rimossi (erase), purchè si tratti del record corrente; l'inserimento
+		 * di nuovi record o la rimozione di altri record, invece, invalidano il cursore.
+		 */
+		class cursor {
+		public :
+				explicit cursor (const storage& _storage) throw () : __storage(_storage), __ID(0) {}
+				virtual ~cursor () {}
+				virtual bool next () throw () = 0;
+				unsigned long ID () const throw ()
+						{return __ID;}
+				virtual void visit (visitor& _visitor) const throw (basic_exception&)
+						{__storage.visit(__ID, _visitor);}
+		protected :
+				const storage&	__storage;
+				unsigned long	__ID;
+		};
+
+		/* La funzione rows restituisce un cursore (vedi cursor) posizionato prima del primo record, nell'ordine dell'indice del gestore. La sua creazione non
+		 * richiede la lettura né l'allocazione di memoria proporzionale al numero di record.
+		 */
+		virtual std::unique_ptr<cursor> rows () const throw () = 0;
+
+		/* La classe reducer consente di visitare tutti i record con più thread contemporaneamente, attraverso la funzione parallel_scan. Ciascun
+		 * thread visita i propri record con un oggetto restituito da fork, che deve essere indipendente dagli altri e può accumulare un risultato parziale;
+		 * al termine della visita i risultati parziali vengono riuniti nell'oggetto originale chiamandone la funzione merge, una volta per ciascun oggetto
+		 * restituito da fork. Per applicare una funzione a ciascun record senza accumulare risultati è sufficiente che fork restituisca una copia
+		 * dell'oggetto e che merge non faccia nulla.
+		 */
+		class reducer : public visitor {
+		public :
+				virtual std::unique_ptr<reducer> fork () const = 0;
+				virtual void merge (reducer& partial) throw (basic_exception&) = 0;
+		};
+
+		/* La funzione parallel_scan visita tutti i record gestiti con threads thread (vedi thread_pool.hpp), o con tutti quelli disponibili se
+		 * threads vale zero. I record vengono suddivisi in blocchi di circa morsel_rows record (morsel), che i thread si contendono fino ad esaurirli, per cui
+		 * un thread rallentato non ritarda gli altri. L'ordine in cui i record vengono visitati non è definito, così come quello in cui vengono riuniti i
+		 * risultati parziali. Durante la visita non è possibile modificare il gestore.
+		 * Un gestore che consente di leggere contemporaneamente blocchi diversi (vedi morsels) viene letto da tutti i thread; per gli altri gestori, i blocchi
+		 * di record vengono letti, uno alla volta, attraverso un cursore (vedi rows) e copiati, e soltanto la loro visita avviene in parallelo.
+		 * Se _reducer o uno degli oggetti da esso creati generano una eccezione, i thread smettono di prelevare blocchi e, al termine della visita, la prima
+		 * eccezione generata viene propagata senza riunire i risultati parziali.
+		 */
+		void parallel_scan (reducer& _reducer, unsigned threads = 0) const throw (basic_exception&);
+
+		static const std::size_t morsel_rows = 1024;
+
+		/* Le funzioni begin_bulk ed end_bulk delimitano un caricamento massivo di record, come quello effettuato da database::load_tuple. Tra le due chiamate il
+		 * gestore può accumulare i record inseriti e renderli persistenti a blocchi (vedi file_storage.hpp); i record restano comunque accessibili in qualsiasi
+		 * momento. Il parametro records, se noto, è il numero di record che verranno inseriti. La funzione end_bulk rende persistenti i record accumulati e può
+		 * generare una eccezione di tipo io_error.
+		 * L'implementazione di default non fa nulla.
+		 */
+		virtual void begin_bulk (unsigned long) throw () {}
+		virtual void end_bulk () throw (storage_exception&) {}
+
+		/* Le funzioni epoch consentono di associare al contenuto del gestore una stringa che ne identifica la versione, ad esempio lo stato della tabella remota
+		 * da cui i record sono stati caricati (vedi database::load_tuple). Un gestore che conserva i record tra una esecuzione e la successiva (vedi file_storage.hpp)
+		 * conserva anche questa stringa; gli altri gestori restituiscono sempre una stringa vuota.
+		 */
+		virtual std::string epoch () const throw ()
+				{return std::string();}
+		virtual void epoch (std::string) throw () {}
+
+		/* La funzione allocation_stats restituisce le statistiche dell'arena in cui il gestore alloca i record (vedi arena.hpp e memory_storage.hpp). I gestori
+		 * che non utilizzano un'arena restituiscono statistiche nulle.
+		 */
+		virtual arena::statistics allocation_stats () const throw ()
+				{return arena::statistics();}
+
+		/* La funzione dictionary_stats restituisce, per ogni colonna testuale, le statistiche del dizionario con cui il gestore ne codifica i valori (vedi
+		 * dictionary.hpp e memory_storage.hpp). I gestori che non utilizzano un dizionario restituiscono una mappa vuota.
+		 */
+		virtual std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>> dictionary_stats () const throw ()
+				{return std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>>(new std::unordered_map<std::string, dictionary::statistics>);}
+
 protected :
 		unsigned long 	__lastKey;
+
+		/* __pending contiene lo stato dei record elencati dalla funzione pending. Ciascun gestore deve chiamare la funzione track ogni volta che lo stato di
+		 * un record viene stabilito o modificato (insert, update, cancel), la funzione untrack quando un record viene rimosso e svuotare __pending in clear;
+		 * un gestore che conserva i record tra una esecuzione e la successiva deve ricostruire __pending quando li riacquisisce.
+		 */
+		std::map<unsigned long, enum record::state>	__pending;
+		void track (unsigned long ID, enum record::state _state) throw () {
+			if (_state == record::inserting || _state == record::updating || _state == record::deleting)
+				__pending[ID] = _state;
+			else if (!__pending.empty())
+				__pending.erase(ID);
+		}
+		void untrack (unsigned long ID) throw ()
+				{__pending.erase(ID);}
+
+		/* La funzione morsels restituisce il numero di blocchi in cui sono suddivisi i record gestiti e visit_morsel visita quelli del blocco morsel, in
+		 * modo che la visita di tutti i blocchi equivalga a quella della funzione scan. La funzione visit_morsel deve poter essere chiamata
+		 * contemporaneamente da più thread su blocchi diversi. L'implementazione di default restituisce zero: il gestore non consente la lettura in
+		 * parallelo (vedi parallel_scan).
+		 */
+		virtual std::size_t morsels () const throw ()
+				{return 0;}
+		virtual void visit_morsel (std::size_t, visitor&) const throw (basic_exception&) {}
+
+		/* key_cursor implementa un cursore sulle chiavi di un contenitore associativo, del quale riceve gli iteratori begin ed end. L'iteratore al record
+		 * successivo viene calcolato prima che il record corrente possa essere rimosso, per cui la rimozione di quest'ultimo non invalida il cursore.
+		 */
+		template <typename iterator> class key_cursor : public cursor {
+		public :
+				key_cursor (const storage& _storage, iterator begin, iterator end) throw () : cursor(_storage), __current(begin), __next(begin), __end(end) {}
+				virtual bool next () throw () {
+					if (__next == __end)
+						return false;
+					__current = __next++;
+					__ID = __current->first;
+					return true;
+				}
+		protected :
+				iterator	__current;
+				iterator	__next;
+				iterator	__end;
+		};
 }; /* end of storage class definition */
 
 }; /*	end of openDB namespace	*/
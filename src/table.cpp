@@ -13,10 +13,32 @@
 #include <fstream>
 using namespace openDB;
 
-table::table (std::string tableName, std::string storageDirectory, schema* parent, bool managesResult, bool store_on_file) throw (basic_exception&) : __parent(parent),__managesResult(managesResult) {
+table::table (std::string tableName, std::string storageDirectory, schema* parent, bool managesResult, bool store_on_file) throw (basic_exception&) :
+	table(tableName, storageDirectory, parent, managesResult, (store_on_file ? on_file : in_memory)) {}
+
+table::table (std::string tableName, std::string storageDirectory, schema* parent, bool managesResult, enum storage_type type, bool reattach) throw (basic_exception&) : __parent(parent),__managesResult(managesResult) {
 	(!tableName.empty() ? __tableName = tableName : throw access_exception("Error creating a table: you can not create a table with no name. Check the 'tableName' paramether."));
-	((store_on_file && storageDirectory.empty()) ? throw storage_exception("Error creating table '" + tableName + "': you must specify where to store table's rows. Check the 'storageDirectory' paramether.") : __storageDirectory = storageDirectory);
-	(store_on_file ? __storage = std::unique_ptr<storage>(new file_storage(storageDirectory + __tableName + ".oDB")) : __storage = std::unique_ptr<storage>(new memory_storage));
+	((type != in_memory && type != in_columns && storageDirectory.empty()) ? throw storage_exception("Error creating table '" + tableName + "': you must specify where to store table's rows. Check the 'storageDirectory' paramether.") : __storageDirectory = storageDirectory);
+	switch (type) {
+		case in_memory :
+			__storage = std::unique_ptr<storage>(new memory_storage(managesResult, managesResult));
+			break;
+		case on_file :
+			__storage = std::unique_ptr<storage>(new file_storage(storageDirectory + __tableName + ".oDB", reattach));
+			break;
+		case on_mapped_file :
+			__storage = std::unique_ptr<storage>(new mmap_storage(storageDirectory + __tableName + ".oDB", mmap_storage::default_chunk, reattach));
+			break;
+		case on_pages :
+			__storage = std::unique_ptr<storage>(new page_storage(storageDirectory + __tableName + ".oDB", page_storage::default_page_size, page_storage::default_budget, reattach));
+			break;
+		case hybrid :
+			__storage = std::unique_ptr<storage>(new hybrid_storage(storageDirectory + __tableName + ".oDB", hybrid_storage::default_budget));
+			break;
+		case in_columns :
+			__storage = std::unique_ptr<storage>(new column_storage(managesResult));
+			break;
+	}
 }
 
 void table::add_column(std::string columnName, sqlType::type_base* columnType, bool key) throw (column_exists&) {
@@ -24,6 +46,7 @@ void table::add_column(std::string columnName, sqlType::type_base* columnType, b
 		throw column_exists("'" + columnName + "' already exists in table'" + __tableName + "'");
 	__columnsMap.insert(std::pair<std::string, column>(columnName, column(columnName, columnType, this, key)));
 	__columnsOrder.push_back(columnName);
+	__declaration = record::descriptor::declare(__columnsMap);		//le righe lette da file fanno riferimento al descrittore di base attraverso la sua impronta
 }
 
 
@@ -50,27 +73,49 @@ void table::to_html (std::string fileName, bool print_row, std::string bgcolor)
 		file <<"<td><b>" <<*it <<"</b></td>" <<std::endl;
 	file <<"</tr>" <<std::endl;
 
-	bool hightlight = true;
-	std::unique_ptr<std::list<unsigned long>> record_id = __storage->internalID();
-	for (std::list<unsigned long>::const_iterator id_it = record_id->begin(); id_it != record_id->end(); id_it++) {
-		if (__storage->visible(*id_it)) {
-			((print_row && hightlight) ? file <<"<tr bgcolor=\"" <<bgcolor <<"\">" <<std::endl : file <<"<tr>" <<std::endl);
-			std::unique_ptr<std::unordered_map<std::string, std::string>> values = __storage->current(*id_it);
-			for (std::list <std::string>::const_iterator it =  __columnsOrder.begin(); it != __columnsOrder.end(); it++)
-				file <<"<td>" <<values->find(*it)->second <<"</td>" <<std::endl;
-			file <<"</tr>" <<std::endl;
-			hightlight =! hightlight;
+	class html_rows : public storage::visitor {
+	public :
+		html_rows (std::fstream& file, const std::list<std::string>& columnsOrder, bool print_row, std::string bgcolor) :
+			__file(file), __print_row(print_row), __bgcolor(bgcolor), __hightlight(true) {
+			for (std::list <std::string>::const_iterator it =  columnsOrder.begin(); it != columnsOrder.end(); it++)
+				__columns.push_back(record::handle(*it));
 		}
-	}
+		virtual void visit (unsigned long, const record& _record) throw (basic_exception&) {
+			if (!_record.visible())
+				return;
+			field value;
+			((__print_row && __hightlight) ? __file <<"<tr bgcolor=\"" <<__bgcolor <<"\">" <<std::endl : __file <<"<tr>" <<std::endl);
+			for (std::vector<record::handle>::const_iterator it = __columns.begin(); it != __columns.end(); it++) {
+				__file <<"<td>";
+				if (_record.current(*it, value))
+					__file.write(value.data(), value.size());
+				__file <<"</td>" <<std::endl;
+			}
+			__file <<"</tr>" <<std::endl;
+			__hightlight =! __hightlight;
+		}
+	private :
+		std::fstream& __file;
+		std::vector<record::handle> __columns;
+		bool __print_row;
+		std::string __bgcolor;
+		bool __hightlight;
+	} rows(file, __columnsOrder, print_row, bgcolor);
+	__storage->scan(rows);
 
 	file<<"</table>" <<std::endl
-	<<"<p><p>" <<std::to_string(record_id->size()).c_str() <<" rows" <<std::endl
+	<<"<p><p>" <<std::to_string(__storage->numRecords()).c_str() <<" rows" <<std::endl
 	<<"</body>" <<std::endl
 	<<"</html>" <<std::endl;
 
 	file.close();
 }
 
+std::unique_ptr<std::unordered_map<std::string, std::string>> table::current(unsigned long ID, const std::list<std::string>& columns) const throw (basic_exception&) {
+	for (std::list<std::string>::const_iterator it = columns.begin(); it != columns.end(); it++)
+		get_iterator(*it);
+	return __storage->current(ID, columns);
+}
 
 std::unordered_map<std::string, column>::const_iterator table::get_iterator(std::string columnName) const throw (column_not_exists&) {
 	std::unordered_map <std::string, column>::const_iterator it = __columnsMap.find(columnName);
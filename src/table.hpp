@@ -16,6 +16,10 @@
 #include "storage.hpp"
 #include "memory_storage.hpp"
 #include "file_storage.hpp"
+#include "mmap_storage.hpp"
+#include "page_storage.hpp"
+#include "hybrid_storage.hpp"
+#include "column_storage.hpp"
 #include <memory>
 #include <list>
 #include <unordered_map>
@@ -45,8 +49,28 @@ public:
 		 * 					senso su una tabella di questo tipo, vengono evitate.
 		 * - store_on_file: di default è true, in questo caso le righe gestite dalla tabella vengono memorizzate su file. Nel caso in cui sia false, si può
 		 * 					evitare di specificare un valore per il parametro storageDirectory
+		 *
+		 * La seconda versione del costruttore consente di scegliere esplicitamente il gestore della memorizzazione delle righe attraverso il parametro type, al posto
+		 * del parametro store_on_file:
+		 * - in_memory: le righe vengono memorizzate in memoria ram (vedi memory_storage.hpp); se managesResult è true, i record vengono allocati in un'arena
+		 * 				e i valori testuali codificati con un dizionario;
+		 * - on_file: le righe vengono memorizzate su file (vedi file_storage.hpp);
+		 * - on_mapped_file: le righe vengono memorizzate su un file proiettato in memoria (vedi mmap_storage.hpp). È indicato per tabelle lette molto più spesso di
+		 * 					 quanto vengano modificate.
+		 * - on_pages: le righe vengono memorizzate su un file organizzato in pagine, mantenute in memoria da un buffer_pool (vedi page_storage.hpp). È indicato per
+		 * 			   tabelle più grandi della memoria disponibile, di cui solo una parte delle righe viene usata frequentemente.
+		 * - hybrid: le righe vengono memorizzate in memoria ram finchè non superano hybrid_storage::default_budget byte, oltre i quali le righe usate meno di
+		 * 			 recente vengono spostate su file (vedi hybrid_storage.hpp). Le righe non vengono riutilizzate, anche se reattach è true.
+		 * - in_columns: le righe vengono memorizzate in memoria ram, scomposte per colonna (vedi column_storage.hpp). È indicato per tabelle di cui si
+		 * 				 analizzano poche colonne di molte righe (vedi scan); se managesResult è true, i valori testuali vengono codificati con un dizionario.
+		 * Anche in questo caso, se il parametro storageDirectory non viene specificato e le righe devono essere memorizzate su file, viene generata una eccezione di
+		 * tipo storage_exception.
+		 * Se il parametro reattach è true e le righe vengono memorizzate su file, le righe memorizzate nel file da un precedente oggetto table con lo stesso nome e
+		 * la stessa storageDirectory vengono riutilizzate, se il file è integro (vedi file_storage.hpp).
 		 */
+		enum storage_type {in_memory, on_file, on_mapped_file, on_pages, hybrid, in_columns};
 		table (std::string tableName, std::string storageDirectory, schema* parent = 0, bool managesResult = false, bool store_on_file = true) throw (basic_exception&);
+		table (std::string tableName, std::string storageDirectory, schema* parent, bool managesResult, enum storage_type type, bool reattach = false) throw (basic_exception&);
 
 		/* Questa funzione restituisce il nome di una tabella. Il nome di ogni tabella all'interno di uno stesso schema dovrebbe essere univoco (vedi oggetto
 		 * schema, definito in schema.hpp) perché usato per l'accesso ad esse.
@@ -107,7 +131,7 @@ public:
 		 * access_exception
 		 */
 		void drop_column(std::string columnName) throw (column_not_exists&)
-			{__columnsMap.erase(get_iterator(columnName));}
+			{__columnsMap.erase(get_iterator(columnName)); __declaration = record::descriptor::declare(__columnsMap);}
 
 		/* La funzione get_column restituisce un riferimento, sia costante che non, ad un oggetto column, di cui si specifica il nome, che compone la struttura di un oggetto
 		 * table. Non si tratta di una copia, ma dell'oggetto vero e proprio. Tale riferimento può essere usato per richiamare direttamente i metodi della classe column
@@ -176,6 +200,21 @@ public:
 		std::unique_ptr<std::list<unsigned long>> internalID () const throw ()
 			{return __storage->internalID();}
 
+		/* La funzione rows restituisce un cursore che scorre le righe della tabella una alla volta, senza costruirne l'elenco completo come fa internalID.
+		 * Vedi storage::cursor.
+		 */
+		std::unique_ptr<storage::cursor> rows () const throw ()
+			{return __storage->rows();}
+
+		/* La funzione pending restituisce, in ordine crescente, le chiavi delle righe che devono essere inserite, aggiornate o rimosse dal database remoto
+		 * all'atto del commit; la funzione pending_changes restituisce il numero di righe in ciascuno dei tre casi. Il loro costo dipende soltanto dal numero
+		 * di righe modificate. Vedi storage.hpp.
+		 */
+		std::unique_ptr<std::list<unsigned long>> pending () const throw ()
+			{return __storage->pending();}
+		storage::changes pending_changes () const throw ()
+			{return __storage->pending_changes();}
+
 		/* La funzione numRecords restituisce il numero di record gestiti. Corrisponde al numero di chiavi valide.
 		 */
 		unsigned long numRecords () const throw ()
@@ -208,6 +247,18 @@ public:
 		unsigned long load (std::unordered_map<std::string, std::string>& valuesMap) throw (basic_exception&)
 			{return __storage->insert(valuesMap, __columnsMap, record::loaded);}
 
+		/* Le versioni di insert e load che accettano columns e values inseriscono più tuple con una sola chiamata: values contiene, per ciascuna colonna di
+		 * columns, nello stesso ordine, il vettore dei valori che essa assume nelle diverse tuple (vedi record::batch). Le colonne vengono risolte una sola
+		 * volta per tutte le tuple, per cui conviene usarle, al posto di una sequenza di chiamate alle versioni precedenti, quando si inseriscono molte tuple
+		 * con le stesse colonne. Le tuple ricevono chiavi consecutive e viene restituita la chiave della prima. Oltre alle eccezioni delle versioni precedenti,
+		 * può essere generata una eccezione di tipo invalid_argument se values non contiene un vettore di lunghezza uniforme per ciascuna colonna o se una
+		 * colonna compare più di una volta.
+		 */
+		unsigned long insert (const std::vector<std::string>& columns, const std::vector<std::vector<std::string>>& values) throw (basic_exception&)
+			{return __storage->insert(record::batch(columns, values, __columnsMap), record::inserting);}
+		unsigned long load (const std::vector<std::string>& columns, const std::vector<std::vector<std::string>>& values) throw (basic_exception&)
+			{return __storage->insert(record::batch(columns, values, __columnsMap), record::loaded);}
+
 		/* La funzione update consente di marcare i valori di un record affinchè siano aggiornati correttamente dal database remoto. Prende i seguenti parametri:
 		 * consente di creare una tupla in modo corretto, inserendo opportunamente i dati. I paramentri sono:
 		 * 	- valueMap : mappa il cui primo campo è il nome della colonna in cui inserire il valore contenuto nel secondo campo. Se non esiste nessuna colonna con il nome
@@ -287,6 +338,43 @@ public:
 		std::unique_ptr<std::unordered_map<std::string, std::string>> old(unsigned long ID = 0) const throw (storage_exception&)
 			{return __storage->old(ID);}
 
+		/* La seconda versione della funzione current restituisce soltanto i valori correnti delle colonne columns, senza che il gestore debba ricostruire l'intera
+		 * tupla quando non è necessario (vedi storage.hpp). Oltre alle eccezioni generate dalla prima versione, può generare una eccezione di tipo column_not_exists
+		 * se una delle colonne non appartiene alla tabella.
+		 */
+		std::unique_ptr<std::unordered_map<std::string, std::string>> current(unsigned long ID, const std::list<std::string>& columns) const throw (basic_exception&);
+
+		/* La funzione fetch restituisce i valori correnti delle righe le cui chiavi sono contenute in IDs, nello stesso ordine. È equivalente a chiamare current per
+		 * ciascuna riga, ma consente al gestore della memorizzazione di leggere le righe contemporaneamente. Vedi storage.hpp.
+		 */
+		std::unique_ptr<std::list<std::unordered_map<std::string, std::string>>> fetch (const std::list<unsigned long>& IDs) const throw (storage_exception&)
+			{return __storage->fetch(IDs);}
+
+		/* La funzione scan visita tutte le righe della tabella, nell'ordine in cui il gestore della memorizzazione le legge più rapidamente, chiamando la funzione
+		 * visit di _visitor per ciascuna di esse. Durante la visita non è possibile modificare la tabella. Vedi storage.hpp.
+		 */
+		void scan (storage::visitor& _visitor) const throw (basic_exception&)
+			{__storage->scan(_visitor);}
+
+		/* La seconda versione della funzione scan legge soltanto i valori delle colonne columns di tutte le righe (vedi storage::column_visitor). È il modo più
+		 * efficiente per analizzare poche colonne di molte righe, in particolare se le righe sono memorizzate per colonna (vedi in_columns).
+		 */
+		void scan (const std::vector<std::string>& columns, storage::column_visitor& _visitor) const throw (basic_exception&)
+			{__storage->scan(columns, _visitor);}
+
+		/* La funzione parallel_scan visita tutte le righe della tabella con threads thread, o con tutti quelli disponibili se threads vale zero, riunendo
+		 * infine i risultati parziali dei thread in _reducer (vedi storage::reducer). Conviene usarla al posto di scan per filtri, esportazioni e aggregazioni
+		 * sull'intera tabella. Durante la visita non è possibile modificare la tabella. Vedi storage.hpp.
+		 */
+		void parallel_scan (storage::reducer& _reducer, unsigned threads = 0) const throw (basic_exception&)
+			{__storage->parallel_scan(_reducer, threads);}
+
+		/* La funzione visit chiama la funzione visit di _visitor per la sola riga ID, consentendo di leggerne i valori senza copiarli (vedi record::current e
+		 * storage.hpp). Può generare le stesse eccezioni della funzione current.
+		 */
+		void visit (unsigned long ID, storage::visitor& _visitor) const throw (basic_exception&)
+			{__storage->visit(ID, _visitor);}
+
 		/* La funzione to_html genera una pagina html molto minimalista, contenente tutte le informazioni gestite dall'oggetto table, organizzate per righe e per colonne.
 		 * La funzione prende tre parametri:
 		 * 	- fileName: nome del file di output;
@@ -302,6 +390,33 @@ public:
 		 */
 		void to_html(std::string fileName, bool print_row = true, std::string bgcolor="#e6e6e6") const throw (storage_exception&);
 
+		/* Le funzioni begin_bulk ed end_bulk delimitano un caricamento massivo di righe, ad esempio una sequenza di chiamate a load, consentendo al gestore della
+		 * memorizzazione di scrivere le righe a blocchi. Il parametro records, se noto, è il numero di righe che verranno caricate. Vedi storage.hpp.
+		 */
+		void begin_bulk (unsigned long records = 0) throw ()
+			{__storage->begin_bulk(records);}
+		void end_bulk () throw (storage_exception&)
+			{__storage->end_bulk();}
+
+		/* Le funzioni epoch restituiscono ed impostano la stringa che identifica la versione delle righe memorizzate dalla tabella. Se le righe sono memorizzate su
+		 * file, l'epoch viene conservato insieme ad esse. Vedi storage.hpp e database::load_tuple.
+		 */
+		std::string epoch () const throw ()
+			{return __storage->epoch();}
+		void epoch (std::string _epoch) throw ()
+			{__storage->epoch(_epoch);}
+
+		/* La funzione allocation_stats restituisce le statistiche dell'allocatore usato per le righe della tabella. Vedi storage.hpp e arena.hpp.
+		 */
+		arena::statistics allocation_stats () const throw ()
+			{return __storage->allocation_stats();}
+
+		/* La funzione dictionary_stats restituisce, per ogni colonna testuale, le statistiche della codifica a dizionario dei suoi valori, scelta
+		 * automaticamente in base al numero di valori distinti. Vedi storage.hpp e dictionary.hpp.
+		 */
+		std::unique_ptr<std::unordered_map<std::string, dictionary::statistics>> dictionary_stats () const throw ()
+			{return __storage->dictionary_stats();}
+
 		/**/
 		schema* get_parent() const throw()
 			{return __parent;}
@@ -321,6 +436,9 @@ private:
 																			 * 	ordine di creazione.
 																			 */
 		std::list<std::string> __columnsOrder;
+
+		/* La dichiarazione delle colonne della tabella, che consente di riconoscere le righe lette da file (vedi record::descriptor::declare). */
+		std::shared_ptr<const record::descriptor> __declaration;
 		/* La funzione get_iterator restituisce un iteratore valido ad un oggetto di classe column. Se l'oggetto non dovesse esistere, viene generata una eccezione
 		 * di tipo column_not_exist, derivata da access_exception.
 		 * Queste funzioni relativamente semplici vengono usate praticamente ovunque, all'interno di questo modulo, qualora si deve accedere ad un oggetto column, poichè
@@ -0,0 +1,90 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "thread_pool.hpp"
+
+using namespace openDB;
+
+/* L'insieme di cui il thread corrente sta eseguendo un lavoratore. Una chiamata a run annidata in un lavoratore non può acquisire __busy, che il thread
+ * chiamante possiede già se è quello che ha avviato il lavoro, per cui viene riconosciuta prima di accedervi.
+ */
+static thread_local const thread_pool* running = 0;
+
+thread_pool::thread_pool (unsigned threads) throw () : __generation(0), __stop(false) {
+	for (unsigned i = 0; i < threads; i++)
+		__threads.push_back(std::thread(&thread_pool::loop, this));
+}
+
+thread_pool::~thread_pool () {
+	{
+		std::lock_guard<std::mutex> lock(__mutex);
+		__stop = true;
+	}
+	__wake.notify_all();
+	for (std::vector<std::thread>::iterator it = __threads.begin(); it != __threads.end(); it++)
+		it->join();
+}
+
+void thread_pool::run (task& _task, unsigned workers) throw () {
+	std::unique_lock<std::mutex> busy(__busy, std::defer_lock);
+	if (running == this || __threads.empty() || workers < 2 || !busy.try_lock()) {
+		for (unsigned i = 0; i < workers; i++)
+			_task.run(i);
+		return;
+	}
+	std::shared_ptr<job> _job(new job(_task, workers));
+	{
+		std::lock_guard<std::mutex> lock(__mutex);
+		__job = _job;
+		__generation++;
+	}
+	__wake.notify_all();
+	execute(*_job);
+	std::unique_lock<std::mutex> lock(__mutex);
+	while (_job->__pending != 0)
+		__done.wait(lock);
+	__job.reset();
+}
+
+thread_pool& thread_pool::global () throw () {
+	static thread_pool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+	return pool;
+}
+
+void thread_pool::loop () throw () {
+	unsigned long generation = 0;
+	while (true) {
+		std::shared_ptr<job> _job;
+		{
+			std::unique_lock<std::mutex> lock(__mutex);
+			while (!__stop && (!__job || __generation == generation))
+				__wake.wait(lock);
+			if (__stop)
+				return;
+			generation = __generation;
+			_job = __job;
+		}
+		execute(*_job);
+	}
+}
+
+void thread_pool::execute (job& _job) throw () {
+	const thread_pool* previous = running;
+	running = this;
+	for (unsigned worker = _job.__next++; worker < _job.__workers; worker = _job.__next++) {
+		_job.__task.run(worker);
+		if (--_job.__pending == 0) {
+			std::lock_guard<std::mutex> lock(__mutex);
+			__done.notify_all();
+		}
+	}
+	running = previous;
+}
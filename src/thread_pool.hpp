@@ -0,0 +1,82 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef __OPENDB_THREAD_POOL_HEADER__
+#define __OPENDB_THREAD_POOL_HEADER__
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace openDB {
+/* La classe thread_pool mantiene un insieme di thread, creati una sola volta, che eseguono in parallelo i compiti loro affidati attraverso la funzione run.
+ * Un compito è un oggetto di tipo task, la cui funzione run viene chiamata una volta per ciascun lavoratore, ricevendone l'indice: è compito di task
+ * suddividere il lavoro tra i lavoratori, ad esempio distribuendo blocchi di record (vedi storage::scan). Anche il thread che chiama run partecipa
+ * all'esecuzione, per cui il numero di lavoratori disponibili, restituito da size, è pari al numero di thread dell'insieme più uno.
+ * La funzione global restituisce l'insieme condiviso dall'intera libreria, che contiene un thread per ciascun processore disponibile meno uno.
+ */
+class thread_pool {
+public:
+		class task {
+		public :
+				virtual ~task () {}
+				virtual void run (unsigned worker) throw () = 0;
+		};
+
+		/* Il costruttore crea threads thread; il distruttore attende che terminino.
+		 */
+		explicit thread_pool (unsigned threads) throw ();
+		~thread_pool ();
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator= (const thread_pool&) = delete;
+
+		unsigned size () const throw ()
+			{return __threads.size() + 1;}
+
+		/* La funzione run chiama _task.run(i) per ciascun i compreso tra zero e workers - 1, ciascuna volta su un thread diverso, e restituisce quando tutte
+		 * le chiamate sono terminate. Se workers è maggiore di size, alcuni lavoratori vengono eseguiti in sequenza dallo stesso thread. Se l'insieme sta già
+		 * eseguendo un altro compito, ad esempio perché run viene chiamata da uno dei lavoratori, i lavoratori vengono eseguiti in sequenza dal thread
+		 * chiamante.
+		 */
+		void run (task& _task, unsigned workers) throw ();
+
+		static thread_pool& global () throw ();
+
+private:
+		/* Il lavoro in corso: next è l'indice del prossimo lavoratore da eseguire, pending il numero di lavoratori non ancora terminati. Un thread che si
+		 * risveglia in ritardo può trovare un lavoro già concluso, per cui il lavoro è condiviso tra run ed i thread.
+		 */
+		struct job {
+				job (task& _task, unsigned _workers) throw () : __task(_task), __workers(_workers), __next(0), __pending(_workers) {}
+				task&					__task;
+				unsigned				__workers;
+				std::atomic<unsigned>	__next;
+				std::atomic<unsigned>	__pending;
+		};
+
+		std::vector<std::thread>	__threads;
+		std::mutex					__mutex;
+		std::mutex					__busy;			/*	acquisito da run per l'intera durata del lavoro	*/
+		std::condition_variable		__wake;
+		std::condition_variable		__done;
+		std::shared_ptr<job>		__job;
+		unsigned long				__generation;
+		bool						__stop;
+
+		void loop () throw ();
+		void execute (job& _job) throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
@@ -0,0 +1,81 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "trash.hpp"
+using namespace openDB;
+
+void trash::clear() throw () {
+	__byOffset.clear();
+	__bySize.clear();
+	__bytes = 0;
+	__recycled = 0;
+	__missed = 0;
+	__merged = 0;
+}
+
+void trash::push (std::streamoff begin, std::streamoff end) throw () {
+	std::map<std::streamoff, std::streamoff>::iterator next = __byOffset.lower_bound(begin);
+	if (next != __byOffset.end() && next->first == end + 1) {	//il segmento successivo è adiacente: viene assorbito
+		end = next->second;
+		std::map<std::streamoff, std::streamoff>::iterator tmp = next++;
+		remove(tmp);
+		__merged++;
+	}
+	if (next != __byOffset.begin()) {
+		std::map<std::streamoff, std::streamoff>::iterator prev = next;
+		prev--;
+		if (prev->second + 1 == begin) {						//il segmento precedente è adiacente: viene assorbito
+			begin = prev->first;
+			remove(prev);
+			__merged++;
+		}
+	}
+	insert(begin, end);
+}
+
+bool trash::pop (std::streamoff byte, std::streamoff& begin) throw () {
+	std::set<std::pair<std::streamoff, std::streamoff>>::iterator fit = __bySize.lower_bound(std::pair<std::streamoff, std::streamoff>(byte, 0));
+	if (fit == __bySize.end()) {
+		__missed++;
+		return false;
+	}
+	std::map<std::streamoff, std::streamoff>::iterator it = __byOffset.find(fit->second);
+	begin = it->first;
+	std::streamoff end = it->second;
+	remove(it);
+	if (end - begin + 1 > byte)									//la parte eccedente rimane nel cestino
+		insert(begin + byte, end);
+	__recycled++;
+	return true;
+}
+
+trash::statistics trash::stats () const throw () {
+	statistics _stats;
+	_stats.segments = __byOffset.size();
+	_stats.bytes = __bytes;
+	_stats.largest = (__bySize.empty() ? 0 : __bySize.rbegin()->first);
+	_stats.recycled = __recycled;
+	_stats.missed = __missed;
+	_stats.merged = __merged;
+	return _stats;
+}
+
+void trash::insert (std::streamoff begin, std::streamoff end) throw () {
+	__byOffset.insert(std::pair<std::streamoff, std::streamoff>(begin, end));
+	__bySize.insert(std::pair<std::streamoff, std::streamoff>(end - begin + 1, begin));
+	__bytes += end - begin + 1;
+}
+
+void trash::remove (std::map<std::streamoff, std::streamoff>::iterator it) throw () {
+	__bySize.erase(std::pair<std::streamoff, std::streamoff>(it->second - it->first + 1, it->first));
+	__bytes -= it->second - it->first + 1;
+	__byOffset.erase(it);
+}
@@ -0,0 +1,96 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OPENDB_TRASH_HEADER__
+#define __OPENDB_TRASH_HEADER__
+
+#include <map>
+#include <set>
+#include <utility>
+#include <ios>
+
+namespace openDB {
+/* La classe trash gestisce lo spazio libero all'interno di un file di record (vedi file_storage.hpp), ossia i segmenti rilasciati dai record modificati o
+ * cancellati, affinchè possano essere riutilizzati.
+ * I segmenti liberi sono indicizzati due volte:
+ * 	- per offset, in modo che un segmento rilasciato possa essere fuso con i segmenti adiacenti, se ne esistono, in tempo logaritmico;
+ * 	- per dimensione, in modo che una richiesta di spazio venga soddisfatta dal più piccolo segmento sufficientemente grande (best-fit), anch'essa in tempo
+ * 	  logaritmico.
+ * Un segmento è individuato dall'offset del suo primo byte, begin, e dall'offset del suo ultimo byte, end.
+ */
+class trash {
+public:
+		/* La struttura statistics raccoglie i contatori relativi allo spazio libero:
+		 * 	- segments: numero di segmenti liberi;
+		 * 	- bytes: numero complessivo di byte liberi;
+		 * 	- largest: dimensione, in byte, del segmento libero più grande;
+		 * 	- recycled: numero di richieste di spazio soddisfatte riutilizzando un segmento libero;
+		 * 	- missed: numero di richieste di spazio che non è stato possibile soddisfare;
+		 * 	- merged: numero di volte in cui un segmento rilasciato è stato fuso con un segmento adiacente.
+		 * La funzione fragmentation restituisce un valore compreso tra 0 e 1: vale 0 se lo spazio libero è tutto contiguo (o non c'è spazio libero) e tende ad 1
+		 * man mano che lo spazio libero è sparpagliato in segmenti sempre più piccoli.
+		 */
+		struct statistics {
+				unsigned long	segments;
+				std::streamoff	bytes;
+				std::streamoff	largest;
+				unsigned long	recycled;
+				unsigned long	missed;
+				unsigned long	merged;
+				statistics() : segments(0), bytes(0), largest(0), recycled(0), missed(0), merged(0) {}
+				double fragmentation() const
+					{return (bytes == 0 ? 0 : 1 - (double) largest / (double) bytes);}
+		};
+
+		trash() throw () : __bytes(0), __recycled(0), __missed(0), __merged(0) {}
+
+		/* La funzione clear svuota il cestino e azzera i contatori.
+		 */
+		void clear() throw ();
+
+		/* La funzione push rilascia il segmento [begin, end], fondendolo con gli eventuali segmenti liberi adiacenti.
+		 */
+		void push (std::streamoff begin, std::streamoff end) throw ();
+
+		/* La funzione pop cerca il più piccolo segmento libero di almeno byte byte. Se esiste, ne vengono utilizzati i primi byte byte, la cui posizione viene
+		 * restituita in begin, e la funzione restituisce true; la parte eccedente del segmento rimane nel cestino. Se non esiste nessun segmento sufficientemente
+		 * grande la funzione restituisce false.
+		 */
+		bool pop (std::streamoff byte, std::streamoff& begin) throw ();
+
+		/* La funzione empty restituisce true se il cestino non contiene segmenti liberi.
+		 */
+		bool empty () const throw ()
+			{return __byOffset.empty();}
+
+		/* La funzione bytes restituisce il numero complessivo di byte liberi.
+		 */
+		std::streamoff bytes () const throw ()
+			{return __bytes;}
+
+		/* La funzione stats restituisce i contatori relativi allo spazio libero. Vedi la struttura statistics.
+		 */
+		statistics stats () const throw ();
+
+private:
+		std::map<std::streamoff, std::streamoff>					__byOffset;		/*	segmenti liberi, indicizzati per offset: begin -> end	*/
+		std::set<std::pair<std::streamoff, std::streamoff>>			__bySize;		/*	segmenti liberi, ordinati per dimensione: (size, begin)	*/
+		std::streamoff												__bytes;
+		unsigned long												__recycled;
+		unsigned long												__missed;
+		unsigned long												__merged;
+
+		void insert (std::streamoff begin, std::streamoff end) throw ();
+		void remove (std::map<std::streamoff, std::streamoff>::iterator it) throw ();
+};
+}; /*	end of openDB namespace	*/
+#endif
@@ -0,0 +1,196 @@
+/* Copyright 2013-2014 Salvatore Barone <salvator.barone@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Il programma storageTest verifica e misura la gestione dello spazio libero nei file dei gestori file_storage e mmap_storage (vedi trash.hpp e
+ * file_storage.hpp). Non usa Qt né il database remoto e si compila con "make -f storageTest.mk".
+ *
+ * storageTest replay [file|mmap] [righe] [operazioni]
+ * 		memorizza righe record, poi esegue operazioni modifiche, cancellazioni ed inserimenti scelti a caso, con valori di lunghezza variabile, e
+ * 		confronta ogni record con una copia mantenuta in memoria, anche dopo la compattazione. Stampa la durata delle operazioni e le statistiche del
+ * 		cestino. Per default righe vale 200000 e operazioni 100000.
+ * storageTest fragmentation [slack] [righe] [modifiche]
+ * 		memorizza righe record, poi modifica una colonna di un record scelto a caso per modifiche volte: il 70% delle modifiche mantiene la lunghezza del
+ * 		valore, il 30% la aumenta o la riduce fino a 8 byte. Stampa la durata delle modifiche, la dimensione del file, lo spazio libero e il numero di
+ * 		volte in cui è stato cercato spazio nel cestino, compresi gli inserimenti iniziali. slack è lo spazio riservato ai record spostati (vedi
+ * 		file_storage::update_slack); per default vale file_storage::default_update_slack, righe 100000 e modifiche 300000.
+ * Il programma restituisce 0 se tutti i record letti corrispondono a quelli attesi, 1 altrimenti.
+ */
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "file_storage.hpp"
+#include "mmap_storage.hpp"
+using namespace openDB;
+
+static const std::string fileName = "/tmp/storageTest.oDB";
+
+static long elapsed (std::chrono::steady_clock::time_point begin) {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static long file_size () {
+	struct stat info;
+	return (stat(fileName.c_str(), &info) == 0 ? info.st_size : 0);
+}
+
+static void print (const trash::statistics& stats) {
+	std::cout	<< "  free segments " << stats.segments << " (" << stats.bytes << " byte, largest " << stats.largest << ")" << std::endl
+				<< "  fragmentation " << stats.fragmentation() << std::endl
+				<< "  allocations   " << stats.recycled + stats.missed << " (" << stats.recycled << " recycled, " << stats.missed << " appended)" << std::endl
+				<< "  merges        " << stats.merged << std::endl;
+}
+
+/* Le righe sono memorizzate in una tabella di due colonne, id e v. La copia in memoria è indicizzata dalla chiave restituita dal gestore; live contiene le
+ * chiavi dei record esistenti, in modo da sceglierne uno a caso in tempo costante.
+ */
+class replay {
+public:
+		replay (file_storage& _storage) : __storage(_storage), __rng(7), __next(0) {
+			__columns.insert(std::pair<std::string, column>("id", column("id", new sqlType::integer, 0, true)));
+			__columns.insert(std::pair<std::string, column>("v", column("v", new sqlType::varchar(400), 0, false)));
+		}
+
+		void insert (std::size_t length, char fill, enum record::state _state) {
+			std::unordered_map<std::string, std::string> valuesMap;
+			valuesMap["id"] = std::to_string(__next++);
+			valuesMap["v"] = std::string(length, fill);
+			unsigned long ID = __storage.insert(valuesMap, __columns, _state);
+			if (ID >= __values.size())
+				__values.resize(ID + 1);
+			__values[ID] = valuesMap;
+			__live.push_back(ID);
+		}
+
+		void update (std::size_t index, std::size_t length, char fill) {
+			std::unordered_map<std::string, std::string>& values = __values[__live[index]];
+			values["v"] = std::string(length, fill);
+			std::unordered_map<std::string, std::string> valuesMap = values;
+			__storage.update(__live[index], valuesMap, __columns);
+		}
+
+		void erase (std::size_t index) {
+			__storage.erase(__live[index]);
+			__values[__live[index]].clear();
+			__live[index] = __live.back();
+			__live.pop_back();
+		}
+
+		void run (unsigned long rows, unsigned long operations) {
+			for (unsigned long i = 0; i < rows; i++)
+				insert(__rng() % 100, 'a', record::loaded);
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			for (unsigned long i = 0; i < operations; i++) {
+				unsigned operation = __rng() % 10;
+				if (__live.empty())
+					operation = 9;
+				if (operation < 6)
+					update(__rng() % __live.size(), __rng() % 300, (char) ('b' + __rng() % 20));
+				else if (operation < 8)
+					erase(__rng() % __live.size());
+				else
+					insert(__rng() % 200, 'z', record::inserting);
+			}
+			std::cout << "replay: " << rows << " rows, " << operations << " operations in " << elapsed(begin) << " ms, file " << file_size() << " byte" << std::endl;
+			print(__storage.trash_statistics());
+		}
+
+		/* La funzione check confronta ogni record con la copia in memoria e restituisce il numero di differenze.
+		 */
+		unsigned long check () const {
+			unsigned long errors = (__storage.numRecords() != __live.size() ? 1 : 0);
+			for (std::vector<unsigned long>::const_iterator it = __live.begin(); it != __live.end(); it++) {
+				std::unique_ptr<std::unordered_map<std::string, std::string>> current = __storage.current(*it);
+				if (*current != __values[*it] || !__storage.visible(*it))
+					errors++;
+			}
+			return errors;
+		}
+
+private:
+		file_storage&													__storage;
+		std::unordered_map<std::string, column>							__columns;
+		std::mt19937													__rng;
+		unsigned long													__next;
+		std::vector<std::unordered_map<std::string, std::string>>		__values;
+		std::vector<unsigned long>										__live;
+};
+
+static int run_replay (const std::string& type, unsigned long rows, unsigned long operations) {
+	std::unique_ptr<file_storage> storage_ptr(type == "mmap" ? new mmap_storage(fileName) : new file_storage(fileName));
+	replay _replay(*storage_ptr);
+	_replay.run(rows, operations);
+	unsigned long errors = _replay.check();
+	storage_ptr->compact();
+	errors += _replay.check();
+	std::cout << "  after compact file " << file_size() << " byte, " << errors << " errors" << std::endl;
+	return (errors == 0 ? 0 : 1);
+}
+
+static int run_fragmentation (double slack, unsigned long rows, unsigned long updates) {
+	std::unordered_map<std::string, column> columnsMap;
+	columnsMap.insert(std::pair<std::string, column>("id", column("id", new sqlType::integer, 0, true)));
+	columnsMap.insert(std::pair<std::string, column>("name", column("name", new sqlType::varchar(400), 0, false)));
+	columnsMap.insert(std::pair<std::string, column>("note", column("note", new sqlType::varchar(400), 0, false)));
+	file_storage _storage(fileName);
+	_storage.update_slack(slack);
+	std::mt19937 rng(3);
+	std::vector<std::size_t> length(rows);
+	for (unsigned long i = 0; i < rows; i++) {
+		length[i] = 60 + rng() % 80;
+		std::unordered_map<std::string, std::string> valuesMap;
+		valuesMap["id"] = std::to_string(i);
+		valuesMap["name"] = std::string(length[i], 'a');
+		valuesMap["note"] = "n";
+		_storage.insert(valuesMap, columnsMap, record::loaded);
+	}
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (unsigned long i = 0; i < updates; i++) {
+		unsigned long ID = rng() % rows;
+		if (rng() % 10 >= 7)		//30%: il valore cresce o si riduce di pochi byte
+			length[ID] = std::max<long>(1, (long) length[ID] + (long) (rng() % 17) - 8);
+		std::unordered_map<std::string, std::string> valuesMap;
+		valuesMap["name"] = std::string(length[ID], (char) ('b' + rng() % 20));
+		_storage.update(ID, valuesMap, columnsMap);
+	}
+	std::cout << "fragmentation: slack " << slack << ", " << rows << " rows, " << updates << " updates in " << elapsed(begin) << " ms, file " << file_size() << " byte" << std::endl;
+	print(_storage.trash_statistics());
+	unsigned long errors = 0;
+	for (unsigned long ID = 0; ID < rows; ID++)
+		if (_storage.current(ID)->at("name").size() != length[ID])
+			errors++;
+	std::cout << "  " << errors << " errors" << std::endl;
+	return (errors == 0 ? 0 : 1);
+}
+
+int main (int argc, char* argv[]) {
+	std::string mode = (argc > 1 ? argv[1] : "");
+	int result = 1;
+	try {
+		if (mode == "replay")
+			result = run_replay((argc > 2 ? argv[2] : "file"), (argc > 3 ? std::stoul(argv[3]) : 200000), (argc > 4 ? std::stoul(argv[4]) : 100000));
+		else if (mode == "fragmentation")
+			result = run_fragmentation((argc > 2 ? std::stod(argv[2]) : file_storage::default_update_slack), (argc > 3 ? std::stoul(argv[3]) : 100000), (argc > 4 ? std::stoul(argv[4]) : 300000));
+		else
+			std::cerr << "usage: " << argv[0] << " replay [file|mmap] [rows] [operations]" << std::endl
+					  << "       " << argv[0] << " fragmentation [slack] [rows] [updates]" << std::endl;
+	}
+	catch (basic_exception& e) {
+		std::cerr << e.what() << std::endl;
+		result = 1;
+	}
+	unlink(fileName.c_str());
+	return result;
+}
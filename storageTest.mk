@@ -0,0 +1,66 @@
+#############################################################################
+# Makefile for building: storageTest
+# Programma di verifica dei gestori di memorizzazione su file (vedi storageTest.cpp), compilato senza Qt:
+#	make -f storageTest.mk
+#	./storageTest replay [file|mmap] [rows] [operations]
+#	./storageTest fragmentation [slack] [rows] [updates]
+#############################################################################
+
+CXX           = g++
+CXXFLAGS      = -m64 -pipe -O2 -Wall -Wextra -D_REENTRANT -std=c++11
+INCPATH       = -I/usr/include/postgresql -Isrc -I.
+LINK          = g++
+LFLAGS        = -m64 -Wl,-O1
+LIBS          = -lpthread -lpq
+DEL_FILE      = rm -f
+MKDIR         = mkdir -p
+
+OBJECTS_DIR   = storageTest.obj/
+TARGET        = storageTest
+
+SOURCES       = src/arena.cpp \
+		src/buffer_pool.cpp \
+		src/cell.cpp \
+		src/column.cpp \
+		src/column_storage.cpp \
+		src/common.cpp \
+		src/connection.cpp \
+		src/database.cpp \
+		src/dbms.cpp \
+		src/dictionary.cpp \
+		src/file_storage.cpp \
+		src/hybrid_storage.cpp \
+		src/io_ring.cpp \
+		src/memory_storage.cpp \
+		src/mmap_storage.cpp \
+		src/page_storage.cpp \
+		src/queryAttribute.cpp \
+		src/record.cpp \
+		src/record_cache.cpp \
+		src/schema.cpp \
+		src/sqlType.cpp \
+		src/storage.cpp \
+		src/table.cpp \
+		src/thread_pool.cpp \
+		src/trash.cpp \
+		src/view.cpp
+OBJECTS       = $(OBJECTS_DIR)storageTest.o $(patsubst src/%.cpp,$(OBJECTS_DIR)%.o,$(SOURCES))
+
+all: $(TARGET)
+
+$(TARGET): $(OBJECTS)
+	$(LINK) $(LFLAGS) -o $(TARGET) $(OBJECTS) $(LIBS)
+
+$(OBJECTS_DIR)storageTest.o: storageTest.cpp $(wildcard src/*.hpp)
+	@$(MKDIR) $(OBJECTS_DIR)
+	$(CXX) -c $(CXXFLAGS) $(INCPATH) -o $@ $<
+
+$(OBJECTS_DIR)%.o: src/%.cpp $(wildcard src/*.hpp)
+	@$(MKDIR) $(OBJECTS_DIR)
+	$(CXX) -c $(CXXFLAGS) $(INCPATH) -o $@ $<
+
+clean:
+	-$(DEL_FILE) $(OBJECTS)
+	-$(DEL_FILE) $(TARGET)
+
+.PHONY: all clean